@@ -1,22 +1,41 @@
 QT -= gui
 
+# the library only; the tools and the tests are separate projects, tools/tools.pro and tests/tests.pro
 TEMPLATE = lib
 DEFINES += QT5INIFORMAT_LIBRARY
 
-CONFIG += c++11
+CONFIG += c++14
 
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    qt5inibatchloader.cpp \
+    qt5inicompactmap.cpp \
     qt5iniformat.cpp \
-    qt5iniimpl.cpp
+    qt5iniimpl.cpp \
+    qt5iniincrementalparser.cpp \
+    qt5inilayered.cpp \
+    qt5inireloader.cpp \
+    qt5inischema.cpp \
+    qt5inisharedcache.cpp \
+    qt5inisnapshot.cpp \
+    qt5inivalidator.cpp
 
 HEADERS += \
     Qt5IniFormat_global.h \
+    qt5inibatchloader.h \
+    qt5inicompactmap.h \
     qt5iniformat.h \
-    qt5iniimpl.h
+    qt5iniimpl.h \
+    qt5iniincrementalparser.h \
+    qt5inilayered.h \
+    qt5inireloader.h \
+    qt5inischema.h \
+    qt5inisharedcache.h \
+    qt5inisnapshot.h \
+    qt5inivalidator.h
 
 CONFIG(debug, debug|release) {
     TARGET = $$join(TARGET,,,d)
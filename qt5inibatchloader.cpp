@@ -0,0 +1,193 @@
+#include "qt5inibatchloader.h"
+#include "qt5iniimpl.h"
+#include <QFile>
+#include <QMutex>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+
+/*
+    One table of key strings shared by all files of a loader. The keys of a
+    parsed map are swapped for the interned strings in place: an equal
+    string leaves the map order intact, so the map is not rebuilt. The
+    table is locked once per file, so parse threads interning at the same
+    time wait for each other; interning is off unless asked for.
+*/
+class BatchKeyInterner
+{
+public:
+    void intern(QSettings::SettingsMap &map)
+    {
+        if (map.isEmpty())
+            return;
+
+        QMutexLocker locker(&mutex);
+        for (QSettings::SettingsMap::iterator it = map.begin(); it != map.end(); ++it) {
+            QString &key = const_cast<QString &>(it.key());
+            QSet<QString>::const_iterator k = table.constFind(key);
+            if (k == table.constEnd())
+                table.insert(key);
+            else
+                key = *k;
+        }
+    }
+
+    int size() const
+    {
+        QMutexLocker locker(&mutex);
+        return table.size();
+    }
+
+    void clear()
+    {
+        QMutexLocker locker(&mutex);
+        table.clear();
+    }
+
+private:
+    mutable QMutex mutex;
+    QSet<QString> table;
+};
+
+class BatchParseTask : public QRunnable
+{
+public:
+    BatchParseTask(const QByteArray &data, Qt5IniLoadResult *result,
+                   BatchKeyInterner *interner, QSemaphore *freeSlots)
+        : data(data), result(result), interner(interner), freeSlots(freeSlots) {}
+
+    void run() override
+    {
+        result->ok = Qt5IniImpl::ReadData(data, result->map);
+        if (!result->ok)
+            result->errorString = QStringLiteral("Malformed INI data");
+        else if (interner)
+            interner->intern(result->map);
+
+        // the buffer is gone before the reader may fetch the next one
+        data.clear();
+        freeSlots->release();
+    }
+
+private:
+    QByteArray data;
+    Qt5IniLoadResult *result;
+    BatchKeyInterner *interner;
+    QSemaphore *freeSlots;
+};
+
+struct Qt5IniBatchLoader::Private
+{
+    QThreadPool pool;
+    int maxPrefetch;
+    bool internKeys;
+    BatchKeyInterner interner;
+
+    /*
+        readInput(i, result, data) runs on the calling thread and fills data
+        for input i, or sets result.errorString and returns false.
+    */
+    template <typename ReadInput>
+    QVector<Qt5IniLoadResult> run(int count, ReadInput readInput)
+    {
+        QVector<Qt5IniLoadResult> results(count);
+        Qt5IniLoadResult *out = results.data();
+        QSemaphore freeSlots(maxPrefetch > 0 ? maxPrefetch : 2 * pool.maxThreadCount());
+
+        for (int i = 0; i < count; ++i) {
+            out[i].ok = false;
+
+            freeSlots.acquire();
+            QByteArray data;
+            if (!readInput(i, out[i], data)) {
+                freeSlots.release();
+                continue;
+            }
+            pool.start(new BatchParseTask(data, &out[i], internKeys ? &interner : nullptr, &freeSlots));
+        }
+
+        pool.waitForDone();
+        return results;
+    }
+};
+
+Qt5IniBatchLoader::Qt5IniBatchLoader(int maxThreads)
+    : d(new Private)
+{
+    d->maxPrefetch = 0;
+    d->internKeys = false;
+    setMaxThreads(maxThreads);
+}
+
+Qt5IniBatchLoader::~Qt5IniBatchLoader()
+{
+}
+
+int Qt5IniBatchLoader::maxThreads() const
+{
+    return d->pool.maxThreadCount();
+}
+
+void Qt5IniBatchLoader::setMaxThreads(int maxThreads)
+{
+    d->pool.setMaxThreadCount(maxThreads > 0 ? maxThreads : QThread::idealThreadCount());
+}
+
+int Qt5IniBatchLoader::maxPrefetch() const
+{
+    return d->maxPrefetch > 0 ? d->maxPrefetch : 2 * d->pool.maxThreadCount();
+}
+
+void Qt5IniBatchLoader::setMaxPrefetch(int maxPrefetch)
+{
+    d->maxPrefetch = maxPrefetch;
+}
+
+QVector<Qt5IniLoadResult> Qt5IniBatchLoader::load(const QStringList &fileNames)
+{
+    return d->run(fileNames.size(), [&fileNames](int i, Qt5IniLoadResult &result, QByteArray &data) {
+        result.fileName = fileNames.at(i);
+        QFile file(result.fileName);
+        if (!file.open(QIODevice::ReadOnly)) {
+            result.errorString = file.errorString();
+            return false;
+        }
+        data = file.readAll();
+        return true;
+    });
+}
+
+QVector<Qt5IniLoadResult> Qt5IniBatchLoader::load(const QList<QIODevice *> &devices)
+{
+    return d->run(devices.size(), [&devices](int i, Qt5IniLoadResult &result, QByteArray &data) {
+        QIODevice *device = devices.at(i);
+        if (!device || !device->isReadable()) {
+            result.errorString = QStringLiteral("Device not readable");
+            return false;
+        }
+        data = device->readAll();
+        return true;
+    });
+}
+
+bool Qt5IniBatchLoader::internKeys() const
+{
+    return d->internKeys;
+}
+
+void Qt5IniBatchLoader::setInternKeys(bool internKeys)
+{
+    d->internKeys = internKeys;
+}
+
+int Qt5IniBatchLoader::internedKeyCount() const
+{
+    return d->interner.size();
+}
+
+void Qt5IniBatchLoader::clearInternedKeys()
+{
+    d->interner.clear();
+}
@@ -0,0 +1,60 @@
+#ifndef QT5INIBATCHLOADER_H
+#define QT5INIBATCHLOADER_H
+
+#include "Qt5IniFormat_global.h"
+#include <QSettings>
+#include <QIODevice>
+#include <QList>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+
+struct Qt5IniLoadResult
+{
+    QString fileName;      // empty when loading devices
+    bool ok;               // what Qt5IniFormatReadFunc returned, false if unreadable
+    QString errorString;
+    QSettings::SettingsMap map;
+};
+
+/*
+    Loads many INI files at once. The calling thread reads the inputs one
+    after the other while a bounded thread pool parses the ones already
+    read, so I/O and parsing overlap; at most maxPrefetch read but not yet
+    parsed buffers are held at any time.
+
+    With setInternKeys(true), keys are interned across all files a loader
+    has seen, so a key that appears in many files is stored once. This
+    saves memory when the maps are kept, at the price of a table lookup
+    per key under a loader-wide lock; it is off by default.
+
+    Every map is exactly what Qt5IniFormatReadFunc returns, and results
+    come back in input order.
+*/
+class QT5INIFORMAT_EXPORT Qt5IniBatchLoader
+{
+public:
+    explicit Qt5IniBatchLoader(int maxThreads = 0);
+    ~Qt5IniBatchLoader();
+
+    int maxThreads() const;
+    void setMaxThreads(int maxThreads);
+    int maxPrefetch() const;
+    void setMaxPrefetch(int maxPrefetch);
+
+    QVector<Qt5IniLoadResult> load(const QStringList &fileNames);
+    QVector<Qt5IniLoadResult> load(const QList<QIODevice *> &devices);
+
+    bool internKeys() const;
+    void setInternKeys(bool internKeys);
+    int internedKeyCount() const;
+    void clearInternedKeys();
+
+private:
+    Q_DISABLE_COPY(Qt5IniBatchLoader)
+
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+#endif // QT5INIBATCHLOADER_H
@@ -0,0 +1,359 @@
+#include "qt5inicompactmap.h"
+#include "qt5iniimpl.h"
+#include <QVector>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+/*
+    Blob layout, all offsets relative to the start of the blob:
+
+        CompactHeader
+        CompactEntry[entryCount]    sorted by key
+        ushort keys[]               UTF-16, not terminated
+        char values[]               raw value bytes as they appear in the file
+*/
+struct CompactHeader
+{
+    quint32 magic;
+    quint32 version;
+    quint32 entryCount;
+    quint32 keysOffset;
+    quint32 valuesOffset;
+    quint32 size;
+};
+
+struct CompactEntry
+{
+    quint32 keyOffset;      // in UTF-16 units from keysOffset
+    quint32 keyLength;
+    quint32 valueOffset;    // in bytes from valuesOffset
+    quint32 valueLength;
+};
+
+static const quint32 CompactMagic = 0x43493551; // "Q5IC"
+static const quint32 CompactVersion = 1;
+
+static inline const CompactHeader *compactHeader(const QByteArray &blob)
+{
+    return reinterpret_cast<const CompactHeader *>(blob.constData());
+}
+
+static inline const CompactEntry *compactEntries(const QByteArray &blob)
+{
+    return reinterpret_cast<const CompactEntry *>(blob.constData() + sizeof(CompactHeader));
+}
+
+static inline const ushort *compactKey(const QByteArray &blob, const CompactEntry &entry)
+{
+    return reinterpret_cast<const ushort *>(blob.constData() + compactHeader(blob)->keysOffset)
+           + entry.keyOffset;
+}
+
+static inline const char *compactValue(const QByteArray &blob, const CompactEntry &entry)
+{
+    return blob.constData() + compactHeader(blob)->valuesOffset + entry.valueOffset;
+}
+
+// same order as QString::operator<
+static int compareUtf16(const ushort *a, int aLength, const ushort *b, int bLength)
+{
+    const int length = qMin(aLength, bLength);
+    for (int i = 0; i < length; ++i) {
+        if (a[i] != b[i])
+            return a[i] < b[i] ? -1 : 1;
+    }
+    return aLength - bLength;
+}
+
+static bool isValidBlob(const QByteArray &blob)
+{
+    if (uint(blob.size()) < sizeof(CompactHeader))
+        return false;
+
+    const CompactHeader *header = compactHeader(blob);
+    const quint64 entriesEnd = sizeof(CompactHeader) + quint64(header->entryCount) * sizeof(CompactEntry);
+    if (header->magic != CompactMagic || header->version != CompactVersion
+        || header->size != quint32(blob.size()) || header->keysOffset != entriesEnd
+        || header->valuesOffset < header->keysOffset || header->valuesOffset > header->size) {
+        return false;
+    }
+
+    const quint64 keyUnits = (header->valuesOffset - header->keysOffset) / sizeof(ushort);
+    const quint64 valueBytes = header->size - header->valuesOffset;
+    const CompactEntry *entries = compactEntries(blob);
+    for (quint32 i = 0; i < header->entryCount; ++i) {
+        if (quint64(entries[i].keyOffset) + entries[i].keyLength > keyUnits
+            || quint64(entries[i].valueOffset) + entries[i].valueLength > valueBytes) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Qt5IniCompactMap::Qt5IniCompactMap()
+{
+}
+
+Qt5IniCompactMap::Qt5IniCompactMap(const QByteArray &blob)
+    : blobData(blob)
+{
+}
+
+Qt5IniCompactMap Qt5IniCompactMap::fromDevice(QIODevice &device, bool *ok)
+{
+    return fromData(device.readAll(), ok);
+}
+
+Qt5IniCompactMap Qt5IniCompactMap::fromData(const QByteArray &iniData, bool *ok)
+{
+    if (ok)
+        *ok = false;
+
+    Qt5IniImpl::SectionMap sections;
+    if (!Qt5IniImpl::ReadSections(iniData, sections))
+        return Qt5IniCompactMap();
+
+    QVector<QByteArray> sectionData;
+    QVector<int> entrySection;
+    QVector<Qt5IniImpl::RawEntry> entries;
+    sectionData.reserve(sections.size());
+
+    for (Qt5IniImpl::SectionMap::const_iterator it = sections.constBegin(); it != sections.constEnd(); ++it) {
+        const int firstEntry = entries.size();
+        if (!Qt5IniImpl::ReadRawSection(it.key(), it.value(), entries))
+            return Qt5IniCompactMap();
+        for (int i = firstEntry; i < entries.size(); ++i)
+            entrySection.append(sectionData.size());
+        sectionData.append(it.value());
+    }
+
+    /*
+        ReadFunc inserts the entries in exactly this order, so when a key
+        occurs more than once the last occurrence wins. A stable sort keeps
+        the occurrences in that order.
+    */
+    QVector<int> order(entries.size());
+    for (int i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&entries](int a, int b) {
+        return entries.at(a).key < entries.at(b).key;
+    });
+
+    QVector<int> kept;
+    kept.reserve(order.size());
+    quint64 keyUnits = 0;
+    quint64 valueBytes = 0;
+    for (int i = 0; i < order.size(); ++i) {
+        const Qt5IniImpl::RawEntry &entry = entries.at(order.at(i));
+        if (i + 1 < order.size() && entries.at(order.at(i + 1)).key == entry.key)
+            continue;
+        kept.append(order.at(i));
+        keyUnits += entry.key.size();
+        valueBytes += entry.valueEnd - entry.valueStart;
+    }
+
+    const quint64 keysOffset = sizeof(CompactHeader) + quint64(kept.size()) * sizeof(CompactEntry);
+    const quint64 valuesOffset = keysOffset + keyUnits * sizeof(ushort);
+    const quint64 totalSize = valuesOffset + valueBytes;
+    if (totalSize > quint64(std::numeric_limits<int>::max()))
+        return Qt5IniCompactMap();
+
+    QByteArray blob(int(totalSize), Qt::Uninitialized);
+    char *base = blob.data();
+
+    CompactHeader *header = reinterpret_cast<CompactHeader *>(base);
+    header->magic = CompactMagic;
+    header->version = CompactVersion;
+    header->entryCount = quint32(kept.size());
+    header->keysOffset = quint32(keysOffset);
+    header->valuesOffset = quint32(valuesOffset);
+    header->size = quint32(totalSize);
+
+    CompactEntry *table = reinterpret_cast<CompactEntry *>(base + sizeof(CompactHeader));
+    ushort *keys = reinterpret_cast<ushort *>(base + keysOffset);
+    char *values = base + valuesOffset;
+    quint32 keyPos = 0;
+    quint32 valuePos = 0;
+
+    for (int i = 0; i < kept.size(); ++i) {
+        const Qt5IniImpl::RawEntry &entry = entries.at(kept.at(i));
+        const QByteArray &data = sectionData.at(entrySection.at(kept.at(i)));
+        const quint32 keyLength = quint32(entry.key.size());
+        const quint32 valueLength = quint32(entry.valueEnd - entry.valueStart);
+
+        table[i].keyOffset = keyPos;
+        table[i].keyLength = keyLength;
+        table[i].valueOffset = valuePos;
+        table[i].valueLength = valueLength;
+
+        memcpy(keys + keyPos, entry.key.unicode(), keyLength * sizeof(ushort));
+        memcpy(values + valuePos, data.constData() + entry.valueStart, valueLength);
+        keyPos += keyLength;
+        valuePos += valueLength;
+    }
+
+    if (ok)
+        *ok = true;
+    return Qt5IniCompactMap(blob);
+}
+
+Qt5IniCompactMap Qt5IniCompactMap::fromBlob(const QByteArray &blob, bool *ok)
+{
+    const bool valid = isValidBlob(blob);
+    if (ok)
+        *ok = valid;
+    return valid ? Qt5IniCompactMap(blob) : Qt5IniCompactMap();
+}
+
+Qt5IniCompactMap Qt5IniCompactMap::fromSharedBlob(const QByteArray &blob,
+                                                   const std::shared_ptr<const void> &storage,
+                                                   bool *ok)
+{
+    Qt5IniCompactMap map = fromBlob(blob, ok);
+    if (!map.blobData.isEmpty())
+        map.storage = storage;
+    return map;
+}
+
+QByteArray Qt5IniCompactMap::blob() const
+{
+    return storage ? QByteArray(blobData.constData(), blobData.size()) : blobData;
+}
+
+int Qt5IniCompactMap::size() const
+{
+    return blobData.isEmpty() ? 0 : int(compactHeader(blobData)->entryCount);
+}
+
+int Qt5IniCompactMap::lowerBound(const QString &key) const
+{
+    const ushort *k = reinterpret_cast<const ushort *>(key.unicode());
+    const CompactEntry *entries = blobData.isEmpty() ? nullptr : compactEntries(blobData);
+    int lo = 0;
+    int hi = size();
+    while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        const CompactEntry &entry = entries[mid];
+        if (compareUtf16(compactKey(blobData, entry), int(entry.keyLength), k, key.size()) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+int Qt5IniCompactMap::indexOf(const QString &key) const
+{
+    const int i = lowerBound(key);
+    if (i == size())
+        return -1;
+    const CompactEntry &entry = compactEntries(blobData)[i];
+    if (compareUtf16(compactKey(blobData, entry), int(entry.keyLength),
+                     reinterpret_cast<const ushort *>(key.unicode()), key.size()) != 0) {
+        return -1;
+    }
+    return i;
+}
+
+QString Qt5IniCompactMap::keyAt(int i) const
+{
+    Q_ASSERT(i >= 0 && i < size());
+    const CompactEntry &entry = compactEntries(blobData)[i];
+    return QString(reinterpret_cast<const QChar *>(compactKey(blobData, entry)), int(entry.keyLength));
+}
+
+QByteArray Qt5IniCompactMap::rawValueAt(int i) const
+{
+    Q_ASSERT(i >= 0 && i < size());
+    const CompactEntry &entry = compactEntries(blobData)[i];
+    return QByteArray(compactValue(blobData, entry), int(entry.valueLength));
+}
+
+QVariant Qt5IniCompactMap::valueAt(int i) const
+{
+    Q_ASSERT(i >= 0 && i < size());
+    const CompactEntry &entry = compactEntries(blobData)[i];
+    const QByteArray raw = QByteArray::fromRawData(compactValue(blobData, entry), int(entry.valueLength));
+    return Qt5IniImpl::DecodeValue(raw, 0, raw.size());
+}
+
+QVariant Qt5IniCompactMap::value(const QString &key, const QVariant &defaultValue) const
+{
+    const int i = indexOf(key);
+    return i == -1 ? defaultValue : valueAt(i);
+}
+
+bool Qt5IniCompactMap::keyHasPrefix(int i, const QString &prefix) const
+{
+    const CompactEntry &entry = compactEntries(blobData)[i];
+    return int(entry.keyLength) >= prefix.size()
+           && memcmp(compactKey(blobData, entry), prefix.unicode(), prefix.size() * sizeof(ushort)) == 0;
+}
+
+int Qt5IniCompactMap::keyIndexOf(int i, ushort ch, int from) const
+{
+    const CompactEntry &entry = compactEntries(blobData)[i];
+    const ushort *key = compactKey(blobData, entry);
+    for (int k = from; k < int(entry.keyLength); ++k) {
+        if (key[k] == ch)
+            return k;
+    }
+    return -1;
+}
+
+QStringList Qt5IniCompactMap::allKeys() const
+{
+    QStringList result;
+    const int count = size();
+    result.reserve(count);
+    for (int i = 0; i < count; ++i)
+        result.append(keyAt(i));
+    return result;
+}
+
+QStringList Qt5IniCompactMap::childKeys(const QString &group) const
+{
+    const QString prefix = Qt5IniImpl::GroupPrefix(group);
+    const int count = size();
+    QStringList result;
+
+    for (int i = lowerBound(prefix); i < count && keyHasPrefix(i, prefix); ++i) {
+        if (keyIndexOf(i, '/', prefix.size()) == -1)
+            result.append(keyAt(i).mid(prefix.size()));
+    }
+    return result;
+}
+
+QStringList Qt5IniCompactMap::childGroups(const QString &group) const
+{
+    const QString prefix = Qt5IniImpl::GroupPrefix(group);
+    const int count = size();
+    QStringList result;
+
+    int i = lowerBound(prefix);
+    while (i < count && keyHasPrefix(i, prefix)) {
+        const int slashPos = keyIndexOf(i, '/', prefix.size());
+        if (slashPos == -1) {
+            ++i;
+            continue;
+        }
+
+        // all keys of the child group are adjacent; skip past them in one search
+        const QString childPrefix = keyAt(i).left(slashPos + 1);
+        result.append(childPrefix.mid(prefix.size(), slashPos - prefix.size()));
+        QString childEnd = childPrefix;
+        childEnd[childEnd.size() - 1] = QChar(ushort('/' + 1));
+        i = lowerBound(childEnd);
+    }
+    return result;
+}
+
+QSettings::SettingsMap Qt5IniCompactMap::toSettingsMap() const
+{
+    QSettings::SettingsMap map;
+    const int count = size();
+    for (int i = 0; i < count; ++i)
+        map.insert(map.constEnd(), keyAt(i), valueAt(i));
+    return map;
+}
@@ -0,0 +1,66 @@
+#ifndef QT5INICOMPACTMAP_H
+#define QT5INICOMPACTMAP_H
+
+#include "Qt5IniFormat_global.h"
+#include <QSettings>
+#include <QIODevice>
+#include <QStringList>
+#include <memory>
+
+/*
+    A read-only alternative to QSettings::SettingsMap for very large files.
+    All keys and values live in one contiguous blob: a header, a table of
+    entries sorted by key, the keys as UTF-16 and the values still in their
+    escaped INI form. A value is only decoded into a QVariant when it is
+    asked for.
+
+    The blob contains no pointers, so it can be copied, stored or shared
+    between processes as is and reopened with fromBlob(). fromSharedBlob()
+    opens a blob in memory the map does not own, such as a shared memory
+    segment: the map and its copies keep storage alive, and blob() returns
+    a copy so nothing handed out points into that memory.
+*/
+class QT5INIFORMAT_EXPORT Qt5IniCompactMap
+{
+public:
+    Qt5IniCompactMap();
+
+    static Qt5IniCompactMap fromDevice(QIODevice &device, bool *ok = nullptr);
+    static Qt5IniCompactMap fromData(const QByteArray &iniData, bool *ok = nullptr);
+    static Qt5IniCompactMap fromBlob(const QByteArray &blob, bool *ok = nullptr);
+    static Qt5IniCompactMap fromSharedBlob(const QByteArray &blob,
+                                           const std::shared_ptr<const void> &storage,
+                                           bool *ok = nullptr);
+
+    QByteArray blob() const;
+
+    bool isEmpty() const { return size() == 0; }
+    int size() const;
+
+    int indexOf(const QString &key) const;
+    int lowerBound(const QString &key) const;
+    QString keyAt(int i) const;
+    QVariant valueAt(int i) const;
+    QByteArray rawValueAt(int i) const;
+
+    bool contains(const QString &key) const { return indexOf(key) != -1; }
+    QVariant value(const QString &key, const QVariant &defaultValue = QVariant()) const;
+
+    QStringList allKeys() const;
+    QStringList childKeys(const QString &group) const;
+    QStringList childGroups(const QString &group) const;
+
+    QSettings::SettingsMap toSettingsMap() const;
+
+private:
+    explicit Qt5IniCompactMap(const QByteArray &blob);
+
+    bool keyHasPrefix(int i, const QString &prefix) const;
+    int keyIndexOf(int i, ushort ch, int from) const;
+
+    QByteArray blobData;
+    // what blobData points into when it does not own its bytes
+    std::shared_ptr<const void> storage;
+};
+
+#endif // QT5INICOMPACTMAP_H
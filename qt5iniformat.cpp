@@ -7,3 +7,18 @@ bool Qt5IniFormatReadFunc(QIODevice & device, QSettings::SettingsMap & map){
 bool Qt5IniFormatWriteFunc(QIODevice & device, const QSettings::SettingsMap &map){
     return Qt5IniImpl::WriteFunc(device, map);
 }
+bool Qt5IniFormatReadSections(QIODevice & device, QSettings::SettingsMap & map, const QStringList &sections){
+    return Qt5IniImpl::ReadSectionsOnly(device, map, sections);
+}
+bool Qt5IniFormatReadKeyPrefixes(QIODevice & device, QSettings::SettingsMap & map, const QStringList &keyPrefixes){
+    return Qt5IniImpl::ReadKeyPrefixes(device, map, keyPrefixes);
+}
+bool Qt5IniFormatWrite(QIODevice & device, const QSettings::SettingsMap &map, Qt5IniWriteOptions options){
+    return Qt5IniImpl::WriteFunc(device, map, options);
+}
+bool Qt5IniFormatParallelWriteFunc(QIODevice & device, const QSettings::SettingsMap &map){
+    return Qt5IniImpl::WriteFunc(device, map, Qt5IniParallelWrite);
+}
+bool Qt5IniFormatTextualWriteFunc(QIODevice & device, const QSettings::SettingsMap &map){
+    return Qt5IniImpl::WriteFunc(device, map, Qt5IniTextualTypes);
+}
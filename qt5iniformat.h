@@ -4,7 +4,31 @@
 #include "Qt5IniFormat_global.h"
 #include <QSettings>
 #include <QIODevice>
+#include <QStringList>
+
+enum Qt5IniWriteOption
+{
+    Qt5IniDefaultWrite = 0x0,
+    // serialize sections on the calling thread and idle global pool threads; same bytes as the serial writer
+    Qt5IniParallelWrite = 0x1,
+    /*
+        write QDateTime, QDate, QTime, QUrl and QUuid as readable tags
+        (ISO 8601 @DateTime(...), @Url(...), ...) instead of QDataStream
+        blobs; the reader accepts both forms
+    */
+    Qt5IniTextualTypes = 0x2
+};
+Q_DECLARE_FLAGS(Qt5IniWriteOptions, Qt5IniWriteOption)
+Q_DECLARE_OPERATORS_FOR_FLAGS(Qt5IniWriteOptions)
 
 QT5INIFORMAT_EXPORT bool Qt5IniFormatReadFunc(QIODevice & device, QSettings::SettingsMap & map);
 QT5INIFORMAT_EXPORT bool Qt5IniFormatWriteFunc(QIODevice & device, const QSettings::SettingsMap &map);
+// Qt5IniFormatReadFunc for some sections ("" is General) or for the keys under some prefixes only
+QT5INIFORMAT_EXPORT bool Qt5IniFormatReadSections(QIODevice & device, QSettings::SettingsMap & map, const QStringList &sections);
+QT5INIFORMAT_EXPORT bool Qt5IniFormatReadKeyPrefixes(QIODevice & device, QSettings::SettingsMap & map, const QStringList &keyPrefixes);
+QT5INIFORMAT_EXPORT bool Qt5IniFormatWrite(QIODevice & device, const QSettings::SettingsMap &map, Qt5IniWriteOptions options);
+// Qt5IniFormatWrite with Qt5IniParallelWrite, to register with QSettings::registerFormat
+QT5INIFORMAT_EXPORT bool Qt5IniFormatParallelWriteFunc(QIODevice & device, const QSettings::SettingsMap &map);
+// Qt5IniFormatWrite with Qt5IniTextualTypes, to register with QSettings::registerFormat
+QT5INIFORMAT_EXPORT bool Qt5IniFormatTextualWriteFunc(QIODevice & device, const QSettings::SettingsMap &map);
 #endif // QT5INIFORMAT_H
@@ -33,19 +33,55 @@
 
 #include "qt5iniimpl.h"
 #include <QRect>
+#include <QDateTime>
+#include <QUrl>
+#include <QUuid>
 #include <QIODevice>
 #include <QDataStream>
 #include <QVector>
+#include <QtAlgorithms>
+#include <QCache>
+#include <QThreadStorage>
+#include <QSet>
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define QT5INI_HAVE_SSE2
+#endif
 
+/*
+    Reads are case-sensitive unless a caller asks for Qt::CaseInsensitive
+    (Qt5IniImpl::ReadDataCaseInsensitive). A case-insensitive QSettingsKey
+    compares as its lowercase form and keeps the spelling from the file in
+    originalCaseKey(); callers pass Qt::CaseSensitive for keys that are
+    known to be lowercase already, which skips both the toLower() and the
+    extra string.
+*/
 static const Qt::CaseSensitivity IniCaseSensitivity = Qt::CaseSensitive;
 class QSettingsKey : public QString
 {
 public:
     inline QSettingsKey(const QString &key, Qt::CaseSensitivity cs, int /* position */ = -1)
-        : QString(key) { Q_ASSERT(cs == Qt::CaseSensitive); Q_UNUSED(cs); }
+        : QString(key)
+    {
+        if (cs == Qt::CaseInsensitive) {
+            theOriginalKey = key;
+            QString::operator=(key.toLower());
+        }
+    }
 
-    inline QString originalCaseKey() const { return *this; }
+    inline QString originalCaseKey() const { return theOriginalKey.isNull() ? *this : theOriginalKey; }
+    inline bool wasFolded() const { return !theOriginalKey.isNull(); }
     inline int originalKeyPosition() const { return -1; }
+
+private:
+    QString theOriginalKey;
 };
 
 typedef QMap<QSettingsKey, QByteArray> UnparsedSettingsMap;
@@ -174,7 +210,62 @@ break_out_of_outer_loop:
     lineLen = i - lineStart;
     return lineLen > 0;
 }
-QString variantToString(const QVariant &v)
+/*
+    With Qt5IniTextualTypes, date/time, URL and UUID values are written as
+    readable tags instead of QDataStream blobs:
+
+        @DateTime(2024-05-01T12:30:00.000Z)  ISO 8601 with milliseconds
+        @Date(2024-05-01)
+        @Time(12:30:00.000)
+        @Url(https://example.com/a%20b)     fully encoded
+        @Uuid({67c8770b-44f1-410a-ab9a-f9b5446f13ee})
+
+    A textual @DateTime never starts with the NUL byte that every QDataStream
+    payload starts with, which is how the reader tells the two apart. Values
+    ISO 8601 cannot carry keep the QDataStream form: Qt::TimeZone date times,
+    whose zone id it has no room for, and years outside 0-9999, which Qt
+    writes as an empty string. Qt::ISODateWithMs needs Qt 5.8; with older Qt
+    date times and times are always written as QDataStream blobs.
+*/
+static inline bool iniIsoYear(const QDate &date)
+{
+    return date.year() >= 0 && date.year() <= 9999;
+}
+
+static bool variantToTextualString(const QVariant &v, QString &result)
+{
+    switch (v.type()) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+    case QVariant::DateTime: {
+        const QDateTime dateTime = v.toDateTime();
+        if (dateTime.timeSpec() == Qt::TimeZone || !iniIsoYear(dateTime.date()))
+            return false;
+        result = QLatin1String("@DateTime(") + dateTime.toString(Qt::ISODateWithMs) + QLatin1Char(')');
+        return true;
+    }
+    case QVariant::Time:
+        result = QLatin1String("@Time(") + v.toTime().toString(Qt::ISODateWithMs) + QLatin1Char(')');
+        return true;
+#endif
+    case QVariant::Date: {
+        const QDate date = v.toDate();
+        if (!iniIsoYear(date))
+            return false;
+        result = QLatin1String("@Date(") + date.toString(Qt::ISODate) + QLatin1Char(')');
+        return true;
+    }
+    case QVariant::Url:
+        result = QLatin1String("@Url(") + QString::fromLatin1(v.toUrl().toEncoded()) + QLatin1Char(')');
+        return true;
+    case QVariant::Uuid:
+        result = QLatin1String("@Uuid(") + v.toUuid().toString() + QLatin1Char(')');
+        return true;
+    default:
+        return false;
+    }
+}
+
+QString variantToString(const QVariant &v, Qt5IniWriteOptions options = Qt5IniWriteOptions())
 {
     QString result;
 
@@ -241,6 +332,8 @@ QString variantToString(const QVariant &v)
 #endif // !QT_NO_GEOM_VARIANT
 
     default: {
+        if ((options & Qt5IniTextualTypes) && variantToTextualString(v, result))
+            break;
 #ifndef QT_NO_DATASTREAM
         QDataStream::Version version;
         const char *typeSpec;
@@ -270,15 +363,6 @@ QString variantToString(const QVariant &v)
 
     return result;
 }
-QStringList variantListToStringList(const QVariantList &l)
-{
-    QStringList result;
-    result.reserve(l.count());
-    QVariantList::const_iterator it = l.constBegin();
-    for (; it != l.constEnd(); ++it)
-        result.append(variantToString(*it));
-    return result;
-}
 
 
 
@@ -309,6 +393,102 @@ QStringList splitArgs(const QString &s, int idx)
 }
 
 
+// the value of count decimal digits at p, or -1
+static inline int iniParseDigits(const QChar *p, int count)
+{
+    int value = 0;
+    for (int i = 0; i < count; ++i) {
+        const uint digit = p[i].unicode() - '0';
+        if (digit > 9)
+            return -1;
+        value = value * 10 + int(digit);
+    }
+    return value;
+}
+
+// "YYYY-MM-DD"
+static bool iniParseIsoDate(const QChar *p, QDate &date)
+{
+    if (p[4] != QLatin1Char('-') || p[7] != QLatin1Char('-'))
+        return false;
+    const int y = iniParseDigits(p, 4);
+    const int m = iniParseDigits(p + 5, 2);
+    const int d = iniParseDigits(p + 8, 2);
+    if (y < 0 || m < 0 || d < 0)
+        return false;
+    date = QDate(y, m, d);
+    return date.isValid();
+}
+
+// "HH:MM:SS.zzz"
+static bool iniParseIsoTime(const QChar *p, QTime &time)
+{
+    if (p[2] != QLatin1Char(':') || p[5] != QLatin1Char(':') || p[8] != QLatin1Char('.'))
+        return false;
+    const int h = iniParseDigits(p, 2);
+    const int m = iniParseDigits(p + 3, 2);
+    const int s = iniParseDigits(p + 6, 2);
+    const int ms = iniParseDigits(p + 9, 3);
+    if (h < 0 || m < 0 || s < 0 || ms < 0)
+        return false;
+    time = QTime(h, m, s, ms);
+    return time.isValid();
+}
+
+/*
+    Parsers for the tags variantToTextualString writes. The exact forms it
+    produces are decoded by hand; anything else goes through Qt's own
+    ISO 8601 parser, which reads fractional seconds in either format.
+*/
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+static const Qt::DateFormat IniIsoDateFormat = Qt::ISODateWithMs;
+#else
+static const Qt::DateFormat IniIsoDateFormat = Qt::ISODate;
+#endif
+
+static QDateTime iniDateTimeFromText(const QString &text)
+{
+    if (text.isEmpty())
+        return QDateTime();
+
+    const QChar *p = text.constData();
+    const int len = text.size();
+    QDate date;
+    QTime time;
+    if (len >= 23 && p[10] == QLatin1Char('T') && iniParseIsoDate(p, date) && iniParseIsoTime(p + 11, time)) {
+        if (len == 23)
+            return QDateTime(date, time, Qt::LocalTime);
+        if (len == 24 && p[23] == QLatin1Char('Z'))
+            return QDateTime(date, time, Qt::UTC);
+        if (len == 29 && (p[23] == QLatin1Char('+') || p[23] == QLatin1Char('-')) && p[26] == QLatin1Char(':')) {
+            const int hours = iniParseDigits(p + 24, 2);
+            const int minutes = iniParseDigits(p + 27, 2);
+            if (hours >= 0 && minutes >= 0) {
+                const int offset = (hours * 60 + minutes) * 60;
+                return QDateTime(date, time, Qt::OffsetFromUTC,
+                                 p[23] == QLatin1Char('-') ? -offset : offset);
+            }
+        }
+    }
+    return QDateTime::fromString(text, IniIsoDateFormat);
+}
+
+static QDate iniDateFromText(const QString &text)
+{
+    QDate date;
+    if (text.size() == 10 && iniParseIsoDate(text.constData(), date))
+        return date;
+    return QDate::fromString(text, Qt::ISODate);
+}
+
+static QTime iniTimeFromText(const QString &text)
+{
+    QTime time;
+    if (text.size() == 12 && iniParseIsoTime(text.constData(), time))
+        return time;
+    return QTime::fromString(text, IniIsoDateFormat);
+}
+
 QVariant stringToVariant(const QString &s)
 {
     if (s.startsWith(QLatin1Char('@'))) {
@@ -319,6 +499,16 @@ QVariant stringToVariant(const QString &s)
             } else if (s.startsWith(QLatin1String("@String("))) {
                 // return QVariant(s.midRef(8, s.size() - 9).toString());
                 return QVariant(s.mid(8, s.size() - 9));
+            } else if (s.startsWith(QLatin1String("@DateTime(")) && s.at(10) != QChar::Null) {
+                return QVariant(iniDateTimeFromText(s.mid(10, s.size() - 11)));
+            } else if (s.startsWith(QLatin1String("@Date("))) {
+                return QVariant(iniDateFromText(s.mid(6, s.size() - 7)));
+            } else if (s.startsWith(QLatin1String("@Time("))) {
+                return QVariant(iniTimeFromText(s.mid(6, s.size() - 7)));
+            } else if (s.startsWith(QLatin1String("@Url("))) {
+                return QVariant(QUrl::fromEncoded(s.mid(5, s.size() - 6).toLatin1()));
+            } else if (s.startsWith(QLatin1String("@Uuid("))) {
+                return QVariant(QUuid(s.mid(6, s.size() - 7)));
             } else if (s.startsWith(QLatin1String("@Variant("))
                        || s.startsWith(QLatin1String("@DateTime("))) {
 #ifndef QT_NO_DATASTREAM
@@ -365,73 +555,211 @@ QVariant stringToVariant(const QString &s)
 
     return QVariant(s);
 }
-QVariant stringListToVariantList(const QStringList &l)
+/*
+    Turns the elements of a decoded list into the value ReadFunc returns, in
+    place and in one pass: "@@" escapes are stripped while the list can stay
+    a QStringList, and the first element with an @-type switches to a
+    QVariantList, reusing the elements already seen as plain strings.
+*/
+QVariant stringListToVariantList(QStringList &l)
 {
-    QStringList outStringList = l;
-    for (int i = 0; i < outStringList.count(); ++i) {
-        const QString &str = outStringList.at(i);
+    const int stringCount = l.count();
+    for (int i = 0; i < stringCount; ++i) {
+        const QString &str = l.at(i);
+        if (!str.startsWith(QLatin1Char('@')))
+            continue;
 
-        if (str.startsWith(QLatin1Char('@'))) {
-            if (str.length() >= 2 && str.at(1) == QLatin1Char('@')) {
-                outStringList[i].remove(0, 1);
-            } else {
-                QVariantList variantList;
-                const int stringCount = l.count();
-                variantList.reserve(stringCount);
-                for (int j = 0; j < stringCount; ++j)
-                    variantList.append(stringToVariant(l.at(j)));
-                return variantList;
-            }
+        if (str.length() >= 2 && str.at(1) == QLatin1Char('@')) {
+            l[i].remove(0, 1);
+            continue;
         }
+
+        QVariantList variantList;
+        variantList.reserve(stringCount);
+        for (int j = 0; j < i; ++j)
+            variantList.append(QVariant(l.at(j)));
+        for (int j = i; j < stringCount; ++j)
+            variantList.append(stringToVariant(l.at(j)));
+        return variantList;
     }
-    return outStringList;
+    return l;
 }
 
 static const char hexDigits[] = "0123456789ABCDEF";
-void iniEscapedKey(const QString &key, QByteArray &result)
+
+static inline int hexDigitValue(char ch)
 {
-    result.reserve(result.length() + key.length() * 3 / 2);
-    for (int i = 0; i < key.size(); ++i) {
-        uint ch = key.at(i).unicode();
+    uint c = uchar(ch);
+    if (c - '0' <= 9)
+        return c - '0';
+    c |= 0x20;
+    if (c - 'a' <= 5)
+        return c - 'a' + 10;
+    return -1;
+}
 
-        if (ch == '/') {
-            result += '\\';
-        } else if ((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9')
-                   || ch == '_' || ch == '-' || ch == '.') {
-            result += (char)ch;
-        } else if (ch <= 0xFF) {
-            result += '%';
-            result += hexDigits[ch / 16];
-            result += hexDigits[ch % 16];
+enum { KeyEscape = 0, KeyPlain = 1, KeySlash = 2 };
+
+/*
+    How a Latin-1 key character is written: as is, as a backslash (for '/')
+    or as a %XX escape. Anything above 0xFF becomes %UXXXX.
+*/
+static const uchar keyCharClass[256] =
+    {
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, KeyPlain, KeyPlain, KeySlash,
+        KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain,
+        KeyPlain, KeyPlain, 0, 0, 0, 0, 0, 0,
+        0, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain,
+        KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain,
+        KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain,
+        KeyPlain, KeyPlain, KeyPlain, 0, 0, 0, 0, KeyPlain,
+        0, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain,
+        KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain,
+        KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain, KeyPlain,
+        KeyPlain, KeyPlain, KeyPlain, 0, 0, 0, 0, 0,
+
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+// returns false at the first character that needs a %XX or %UXXXX escape
+static inline bool iniEscapedKeyPlainPrefix(const ushort *unicode, int size, int &i, char *&dst)
+{
+    for (; i < size; ++i) {
+        const uint ch = unicode[i];
+        const uchar cls = ch <= 0xFF ? keyCharClass[ch] : uchar(KeyEscape);
+        if (cls == KeyPlain)
+            *dst++ = char(ch);
+        else if (cls == KeySlash)
+            *dst++ = '\\';
+        else
+            return false;
+    }
+    return true;
+}
+
+static inline void iniEscapedKeyRemainder(const ushort *unicode, int size, int i, char *&dst)
+{
+    for (; i < size; ++i) {
+        const uint ch = unicode[i];
+        if (ch > 0xFF) {
+            *dst++ = '%';
+            *dst++ = 'U';
+            *dst++ = hexDigits[(ch >> 12) & 0xF];
+            *dst++ = hexDigits[(ch >> 8) & 0xF];
+            *dst++ = hexDigits[(ch >> 4) & 0xF];
+            *dst++ = hexDigits[ch & 0xF];
+        } else if (keyCharClass[ch] == KeyPlain) {
+            *dst++ = char(ch);
+        } else if (keyCharClass[ch] == KeySlash) {
+            *dst++ = '\\';
         } else {
-            result += "%U";
-            QByteArray hexCode;
-            for (int i = 0; i < 4; ++i) {
-                hexCode.prepend(hexDigits[ch % 16]);
-                ch >>= 4;
-            }
-            result += hexCode;
+            *dst++ = '%';
+            *dst++ = hexDigits[ch >> 4];
+            *dst++ = hexDigits[ch & 0xF];
+        }
+    }
+}
+
+/*
+    Escaped forms of keys that need %XX escapes, reused across writes. Keys
+    made only of plain characters are cheaper to encode than to look up and
+    never enter the cache. Every thread has its own cache.
+*/
+static const int EscapedKeyCacheSize = 4096;
+static QThreadStorage<QCache<QString, QByteArray> *> escapedKeyCache;
+
+void iniEscapedKey(const QString &key, QByteArray &result)
+{
+    const ushort *unicode = reinterpret_cast<const ushort *>(key.unicode());
+    const int size = key.size();
+    const int startPos = result.size();
+
+    // "%UXXXX" is the longest form a single character can take
+    result.resize(startPos + size * 6);
+    char *dst = result.data() + startPos;
+    int i = 0;
+
+    if (!iniEscapedKeyPlainPrefix(unicode, size, i, dst)) {
+        if (!escapedKeyCache.hasLocalData())
+            escapedKeyCache.setLocalData(new QCache<QString, QByteArray>(EscapedKeyCacheSize));
+        QCache<QString, QByteArray> *cache = escapedKeyCache.localData();
+
+        if (const QByteArray *cached = cache->object(key)) {
+            result.resize(startPos);
+            result += *cached;
+            return;
         }
+
+        iniEscapedKeyRemainder(unicode, size, i, dst);
+        const int escapedSize = int(dst - result.constData()) - startPos;
+        cache->insert(key, new QByteArray(result.constData() + startPos, escapedSize));
+    }
+    result.resize(int(dst - result.constData()));
+}
+/*
+    The value of the digits of a %XX or %UXXXX key escape. Plain hex digits
+    are decoded here; anything else goes through QByteArray::toInt(), which
+    also takes a sign, blanks or a "0x" prefix ("%-1", "% F", "%U0x12"), so
+    such keys keep reading as they always did.
+*/
+static inline int iniKeyEscapeValue(const char *digits, int numDigits, bool *ok)
+{
+    int value = 0;
+    for (int k = 0; k < numDigits; ++k) {
+        const int digit = hexDigitValue(digits[k]);
+        if (digit < 0)
+            return QByteArray(digits, numDigits).toInt(ok, 16);
+        value = (value << 4) | digit;
     }
+    *ok = true;
+    return value;
 }
+
 bool iniUnescapedKey(const QByteArray &key, int from, int to, QString &result)
 {
     bool lowercaseOnly = true;
+    const char *data = key.constData();
     int i = from;
-    result.reserve(result.length() + (to - from));
+
+    // every input byte produces at most one character
+    const int startPos = result.size();
+    result.resize(startPos + (to - from));
+    QChar *dst = result.data() + startPos;
+
     while (i < to) {
-        int ch = (uchar)key.at(i);
+        int ch = (uchar)data[i];
 
         if (ch == '\\') {
-            result += QLatin1Char('/');
+            *dst++ = QLatin1Char('/');
             ++i;
             continue;
         }
 
         if (ch != '%' || i == to - 1) {
-            if (uint(ch - 'A') <= 'Z' - 'A') // only for ASCII
+            if (uint(ch - 'A') <= 'Z' - 'A'
+                    || (ch >= 0xc0 && QChar(ch).toLower() != QChar(ch))) // Latin-1 capitals
                 lowercaseOnly = false;
-            result += QLatin1Char(ch);
+            *dst++ = QLatin1Char(ch);
             ++i;
             continue;
         }
@@ -439,65 +767,175 @@ bool iniUnescapedKey(const QByteArray &key, int from, int to, QString &result)
         int numDigits = 2;
         int firstDigitPos = i + 1;
 
-        ch = key.at(i + 1);
+        ch = data[i + 1];
         if (ch == 'U') {
             ++firstDigitPos;
             numDigits = 4;
         }
 
         if (firstDigitPos + numDigits > to) {
-            result += QLatin1Char('%');
+            *dst++ = QLatin1Char('%');
             // ### missing U
             ++i;
             continue;
         }
 
         bool ok;
-        ch = key.mid(firstDigitPos, numDigits).toInt(&ok, 16);
+        ch = iniKeyEscapeValue(data + firstDigitPos, numDigits, &ok);
         if (!ok) {
-            result += QLatin1Char('%');
+            *dst++ = QLatin1Char('%');
             // ### missing U
             ++i;
             continue;
         }
 
         QChar qch(ch);
-        if (qch.isUpper())
+        if (qch.toLower() != qch)
             lowercaseOnly = false;
-        result += qch;
+        *dst++ = qch;
         i = firstDigitPos + numDigits;
     }
+    result.resize(int(dst - result.constData()));
     return lowercaseOnly;
 }
 
+// appends "\\x" followed by ch in lowercase hex without leading zeros
+static inline void iniAppendHexEscape(QByteArray &result, uint ch)
+{
+    static const char lowerHexDigits[] = "0123456789abcdef";
+    char buf[2 + 8];
+    int n = sizeof(buf);
+    do {
+        buf[--n] = lowerHexDigits[ch & 0xF];
+        ch >>= 4;
+    } while (ch);
+    buf[--n] = 'x';
+    buf[--n] = '\\';
+    result.append(buf + n, int(sizeof(buf)) - n);
+}
+
+static inline bool iniIsHexDigit(uint ch)
+{
+    return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F');
+}
+
+// whether any of ';', ',' or '=' occurs, which forces the value into quotes
+static inline bool iniContainsQuoteTrigger(const ushort *data, int size)
+{
+    int i = 0;
+#ifdef QT5INI_HAVE_SSE2
+    const __m128i semicolon = _mm_set1_epi16(';');
+    const __m128i comma = _mm_set1_epi16(',');
+    const __m128i equals = _mm_set1_epi16('=');
+    for (; i + 8 <= size; i += 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(chunk, semicolon),
+                                                       _mm_cmpeq_epi16(chunk, comma)),
+                                          _mm_cmpeq_epi16(chunk, equals));
+        if (_mm_movemask_epi8(hits))
+            return true;
+    }
+#endif
+    for (; i < size; ++i) {
+        const ushort ch = data[i];
+        if (ch == ';' || ch == ',' || ch == '=')
+            return true;
+    }
+    return false;
+}
+
+// index of the first character in [from, size) that has to be escaped, or size
+static inline int iniFindEscapeNeeded(const ushort *data, int from, int size)
+{
+    int i = from;
+#ifdef QT5INI_HAVE_SSE2
+    // signed compares: everything from 0x8000 up is negative and thus below 0x20
+    const __m128i lowLimit = _mm_set1_epi16(0x20);
+    const __m128i highLimit = _mm_set1_epi16(0x7E);
+    const __m128i quote = _mm_set1_epi16('"');
+    const __m128i backslash = _mm_set1_epi16('\\');
+    for (; i + 8 <= size; i += 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmplt_epi16(chunk, lowLimit),
+                                                       _mm_cmpgt_epi16(chunk, highLimit)),
+                                          _mm_or_si128(_mm_cmpeq_epi16(chunk, quote),
+                                                       _mm_cmpeq_epi16(chunk, backslash)));
+        const uint mask = uint(_mm_movemask_epi8(hits));
+        if (mask)
+            return i + int(qCountTrailingZeroBits(mask)) / 2;
+    }
+#endif
+    for (; i < size; ++i) {
+        const ushort ch = data[i];
+        if (ch <= 0x1F || ch >= 0x7F || ch == '"' || ch == '\\')
+            break;
+    }
+    return i;
+}
+
+// appends [from, to), which only holds printable ASCII, as bytes
+static inline void iniAppendNarrowed(QByteArray &result, const ushort *data, int from, int to)
+{
+    const int len = to - from;
+    const int n = result.size();
+    result.resize(n + len);
+    char *dst = result.data() + n;
+    const ushort *src = data + from;
+
+    int k = 0;
+#ifdef QT5INI_HAVE_SSE2
+    for (; k + 16 <= len; k += 16) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + k));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + k + 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + k), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; k < len; ++k)
+        dst[k] = char(src[k]);
+}
+
+/*
+    Clean runs are found and narrowed in bulk; only the characters that need
+    an escape sequence go through the switch. Whether the value needs quotes
+    depends on the characters ';', ',' and '=' and on a leading or trailing
+    space, none of which is ever escaped, so it is known before anything is
+    emitted and the opening quote never has to be inserted afterwards.
+*/
 void iniEscapedString(const QString &str, QByteArray &result/*, QTextCodec *codec*/)
 {
-    bool needsQuotes = false;
+    const ushort *unicode = reinterpret_cast<const ushort *>(str.unicode());
+    const int size = str.size();
+
+    const bool needsQuotes = size > 0
+                             && (unicode[0] == ' ' || unicode[size - 1] == ' '
+                                 || iniContainsQuoteTrigger(unicode, size));
     bool escapeNextIfDigit = false;
-    // bool useCodec = codec && !str.startsWith(QLatin1String("@ByteArray("))
-    //                 && !str.startsWith(QLatin1String("@Variant("));
 
-    int i;
-    int startPos = result.size();
+    result.reserve(result.size() + size * 3 / 2 + 2);
+    if (needsQuotes)
+        result += '"';
 
-    result.reserve(startPos + str.size() * 3 / 2);
-    const QChar *unicode = str.unicode();
-    for (i = 0; i < str.size(); ++i) {
-        uint ch = unicode[i].unicode();
-        if (ch == ';' || ch == ',' || ch == '=')
-            needsQuotes = true;
-
-        if (escapeNextIfDigit
-            && ((ch >= '0' && ch <= '9')
-                || (ch >= 'a' && ch <= 'f')
-                || (ch >= 'A' && ch <= 'F'))) {
-            result += "\\x";
-            result += QByteArray::number(ch, 16);
-            continue;
+    int i = 0;
+    while (i < size) {
+        if (escapeNextIfDigit) {
+            const uint ch = unicode[i];
+            if (iniIsHexDigit(ch)) {
+                iniAppendHexEscape(result, ch);
+                ++i;
+                continue;
+            }
+            escapeNextIfDigit = false;
         }
 
-        escapeNextIfDigit = false;
+        const int runEnd = iniFindEscapeNeeded(unicode, i, size);
+        if (runEnd != i) {
+            iniAppendNarrowed(result, unicode, i, runEnd);
+            i = runEnd;
+            if (i == size)
+                break;
+        }
 
+        const uint ch = unicode[i++];
         switch (ch) {
         case '\0':
             result += "\\0";
@@ -530,35 +968,106 @@ void iniEscapedString(const QString &str, QByteArray &result/*, QTextCodec *code
             result += (char)ch;
             break;
         default:
-            if (ch <= 0x1F || (ch >= 0x7F /*&& !useCodec*/)) {
-                result += "\\x";
-                result += QByteArray::number(ch, 16);
-                escapeNextIfDigit = true;
-// #ifndef QT_NO_TEXTCODEC
-//             } else if (useCodec) {
-//                 // slow
-//                 result += codec->fromUnicode(&unicode[i], 1);
-// #endif
-            } else {
-                result += (char)ch;
-            }
+            // only control characters and ch >= 0x7F get here
+            iniAppendHexEscape(result, ch);
+            escapeNextIfDigit = true;
         }
     }
 
-    if (needsQuotes
-        || (startPos < result.size() && (result.at(startPos) == ' '
-                                         || result.at(result.size() - 1) == ' '))) {
-        result.insert(startPos, '"');
+    if (needsQuotes)
         result += '"';
+}
+
+enum { EscHex = 0x80, EscOct, EscLine };
+
+/*
+    What follows a backslash in a value: the decoded character for simple
+    escapes, one of the Esc markers above, or 0 if the character is skipped.
+*/
+static const uchar escapeDispatch[256] =
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, EscLine, 0, 0, EscLine, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, '"', 0, 0, 0, 0, '\'', 0, 0, 0, 0, 0, 0, 0, 0,
+        EscOct, EscOct, EscOct, EscOct, EscOct, EscOct, EscOct, EscOct, 0, 0, 0, 0, 0, 0, 0, '?',
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '\\', 0, 0, 0,
+        0, '\a', '\b', 0, 0, 0, '\f', 0, 0, 0, 0, 0, 0, 0, '\n', 0,
+        0, 0, '\r', 0, '\t', 0, '\v', 0, EscHex, 0, 0, 0, 0, 0, 0, 0,
+
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+// index of the first '\\', '"' or ',' in [from, to), or to
+static inline int iniFindValueDelimiter(const char *data, int from, int to)
+{
+    int i = from;
+#ifdef QT5INI_HAVE_SSE2
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i comma = _mm_set1_epi8(',');
+    for (; i + 16 <= to; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, backslash),
+                                                       _mm_cmpeq_epi8(chunk, quote)),
+                                          _mm_cmpeq_epi8(chunk, comma));
+        const uint mask = uint(_mm_movemask_epi8(hits));
+        if (mask)
+            return i + int(qCountTrailingZeroBits(mask));
+    }
+#endif
+    for (; i < to; ++i) {
+        const char ch = data[i];
+        if (ch == '\\' || ch == '"' || ch == ',')
+            break;
+    }
+    return i;
+}
+
+static inline void iniLatin1ToUtf16(ushort *dst, const char *src, int len)
+{
+    int k = 0;
+#ifdef QT5INI_HAVE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; k + 16 <= len; k += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + k));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + k), _mm_unpacklo_epi8(chunk, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + k + 8), _mm_unpackhi_epi8(chunk, zero));
     }
+#endif
+    for (; k < len; ++k)
+        dst[k] = uchar(src[k]);
 }
 
 inline static void iniChopTrailingSpaces(QString &str, int limit)
 {
-    int n = str.size() - 1;
+    int n = str.size();
     QChar ch;
-    while (n >= limit && ((ch = str.at(n)) == QLatin1Char(' ') || ch == QLatin1Char('\t')))
-        str.truncate(n--);
+    while (n > limit && ((ch = str.at(n - 1)) == QLatin1Char(' ') || ch == QLatin1Char('\t')))
+        --n;
+    if (n < str.size())
+        str.truncate(n);
+}
+
+/*
+    The list writers encode element by element straight into result, with
+    the same per-element rules variantToString applies to strings.
+*/
+static inline void iniEscapedStringElement(const QString &str, QByteArray &result)
+{
+    if (str.contains(QChar::Null))
+        iniEscapedString(QLatin1String("@String(") + str + QLatin1Char(')'), result);
+    else if (str.startsWith(QLatin1Char('@')))
+        iniEscapedString(QLatin1Char('@') + str, result);
+    else
+        iniEscapedString(str, result);
 }
 
 void iniEscapedStringList(const QStringList &strs, QByteArray &result)
@@ -577,7 +1086,25 @@ void iniEscapedStringList(const QStringList &strs, QByteArray &result)
         for (int i = 0; i < strs.size(); ++i) {
             if (i != 0)
                 result += ", ";
-            iniEscapedString(strs.at(i), result);
+            iniEscapedStringElement(strs.at(i), result);
+        }
+    }
+}
+
+void iniEscapedVariantList(const QVariantList &list, QByteArray &result, Qt5IniWriteOptions options)
+{
+    if (list.isEmpty()) {
+        // see iniEscapedStringList
+        result += "@Invalid()";
+    } else {
+        for (int i = 0; i < list.size(); ++i) {
+            if (i != 0)
+                result += ", ";
+            const QVariant &v = list.at(i);
+            if (v.type() == QVariant::String)
+                iniEscapedStringElement(v.toString(), result);
+            else
+                iniEscapedString(variantToString(v, options), result);
         }
     }
 }
@@ -585,22 +1112,6 @@ void iniEscapedStringList(const QStringList &strs, QByteArray &result)
 bool iniUnescapedStringList(const QByteArray &str, int from, int to,
                                               QString &stringResult, QStringList &stringListResult)
 {
-    static const char escapeCodes[][2] =
-        {
-            { 'a', '\a' },
-            { 'b', '\b' },
-            { 'f', '\f' },
-            { 'n', '\n' },
-            { 'r', '\r' },
-            { 't', '\t' },
-            { 'v', '\v' },
-            { '"', '"' },
-            { '?', '?' },
-            { '\'', '\'' },
-            { '\\', '\\' }
-        };
-    static const int numEscapeCodes = sizeof(escapeCodes) / sizeof(escapeCodes[0]);
-
     bool isStringList = false;
     bool inQuotedString = false;
     bool currentValueIsQuoted = false;
@@ -623,34 +1134,33 @@ StNormal:
                 goto end;
 
             ch = str.at(i++);
-            for (int j = 0; j < numEscapeCodes; ++j) {
-                if (ch == escapeCodes[j][0]) {
-                    stringResult += QLatin1Char(escapeCodes[j][1]);
-                    goto StNormal;
-                }
-            }
-
-            if (ch == 'x') {
+            switch (const uchar esc = escapeDispatch[uchar(ch)]) {
+            case EscHex:
                 escapeVal = 0;
 
                 if (i >= to)
                     goto end;
 
-                ch = str.at(i);
-                if ((ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'F') || (ch >= 'a' && ch <= 'f'))
+                if (hexDigitValue(str.at(i)) >= 0)
                     goto StHexEscape;
-            } else if (ch >= '0' && ch <= '7') {
+                break;
+            case EscOct:
                 escapeVal = ch - '0';
                 goto StOctEscape;
-            } else if (ch == '\n' || ch == '\r') {
+            case EscLine:
                 if (i < to) {
                     char ch2 = str.at(i);
                     // \n, \r, \r\n, and \n\r are legitimate line terminators in INI files
                     if ((ch2 == '\n' || ch2 == '\r') && ch2 != ch)
                         ++i;
                 }
-            } else {
+                break;
+            case 0:
                 // the character is skipped
+                break;
+            default:
+                stringResult += QLatin1Char(char(esc));
+                goto StNormal;
             }
             chopLimit = stringResult.length();
             break;
@@ -678,20 +1188,13 @@ StNormal:
             }
             // fallthrough
         default: {
-            int j = i + 1;
-            while (j < to) {
-                ch = str.at(j);
-                if (ch == '\\' || ch == '"' || ch == ',')
-                    break;
-                ++j;
-            }
+            const char *data = str.constData();
+            int j = iniFindValueDelimiter(data, i + 1, to);
 
             {
                 int n = stringResult.size();
                 stringResult.resize(n + (j - i));
-                QChar *resultData = stringResult.data() + n;
-                for (int k = i; k < j; ++k)
-                    *resultData++ = QLatin1Char(str.at(k));
+                iniLatin1ToUtf16(reinterpret_cast<ushort *>(stringResult.data() + n), data + i, j - i);
             }
             i = j;
         }
@@ -707,18 +1210,17 @@ StHexEscape:
         goto end;
     }
 
-    ch = str.at(i);
-    if (ch >= 'a')
-        ch -= 'a' - 'A';
-    if ((ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'F')) {
-        escapeVal <<= 4;
-        escapeVal += strchr(hexDigits, ch) - hexDigits;
-        ++i;
-        goto StHexEscape;
-    } else {
-        stringResult += QChar(escapeVal);
-        goto StNormal;
+    {
+        const int digit = hexDigitValue(str.at(i));
+        if (digit >= 0) {
+            escapeVal <<= 4;
+            escapeVal += digit;
+            ++i;
+            goto StHexEscape;
+        }
     }
+    stringResult += QChar(escapeVal);
+    goto StNormal;
 
 StOctEscape:
     if (i >= to) {
@@ -743,27 +1245,75 @@ end:
     return isStringList;
 }
 
-bool readIniSection(const QSettingsKey &section, const QByteArray &data,
-               ParsedSettingsMap *settingsMap)
+static QVariant iniValueToVariant(const QByteArray &data, int valueStart, int valueEnd,
+                                  QStringList &strListValue)
 {
-    QStringList strListValue;
-    bool sectionIsLowercase = (section == section.originalCaseKey());
-    int equalsPos;
+    QString strValue;
+    strValue.reserve(valueEnd - valueStart);
+    bool isStringList = iniUnescapedStringList(data, valueStart, valueEnd,
+                                               strValue, strListValue/*, codec*/);
+    if (isStringList)
+        return stringListToVariantList(strListValue);
+    return stringToVariant(strValue);
+}
 
-    bool ok = true;
-    int dataPos = 0;
-    int lineStart;
-    int lineLen;
-    int position = section.originalKeyPosition();
+/*
+    What IniSectionParser does with each entry: decode the value into a
+    settings map, or, for Qt5IniImpl::ReadRawSection, only record where the
+    value's bytes are.
+*/
+template <typename SettingsMap>
+static inline void iniSectionEntry(SettingsMap *settingsMap, const QString &key,
+                                   Qt::CaseSensitivity keyCs, int position, const QByteArray &data,
+                                   int valueStart, int valueEnd, QStringList &strListValue)
+{
+    QVariant variant = iniValueToVariant(data, valueStart, valueEnd, strListValue);
+    settingsMap->insert(QSettingsKey(key, keyCs, position), variant);
+}
+
+static inline void iniSectionEntry(QVector<Qt5IniImpl::RawEntry> *entries, const QString &key,
+                                   Qt::CaseSensitivity, int, const QByteArray &,
+                                   int valueStart, int valueEnd, QStringList &)
+{
+    Qt5IniImpl::RawEntry entry;
+    entry.key = key;
+    entry.valueStart = valueStart;
+    entry.valueEnd = valueEnd;
+    entries->append(entry);
+}
+
+/*
+    readIniSection and readIniFile are driven by state objects that handle
+    one line per call to next(), so Qt5IniImpl::IncrementalReader can stop
+    between any two lines and pick up again later. IniSectionParser is the
+    only section line loop; Target is a settings map or a RawEntry vector.
+*/
+template <typename Target>
+class IniSectionParser
+{
+public:
+    IniSectionParser(const QSettingsKey &section, const QByteArray &data, Target *target,
+                     Qt::CaseSensitivity cs = IniCaseSensitivity)
+        : section(section), data(data), target(target), cs(cs),
+          sectionIsLowercase(section == section.originalCaseKey()),
+          dataPos(0), position(section.originalKeyPosition()), ok(true) {}
+
+    // parses one line; false once the section is done
+    bool next()
+    {
+        int lineStart;
+        int lineLen;
+        int equalsPos;
+        if (!readIniLine(data, dataPos, lineStart, lineLen, equalsPos))
+            return false;
 
-    while (readIniLine(data, dataPos, lineStart, lineLen, equalsPos)) {
         char ch = data.at(lineStart);
         Q_ASSERT(ch != '[');
 
         if (equalsPos == -1) {
             if (ch != ';')
                 ok = false;
-            continue;
+            return true;
         }
 
         int keyEnd = equalsPos;
@@ -774,59 +1324,122 @@ bool readIniSection(const QSettingsKey &section, const QByteArray &data,
         QString key = section.originalCaseKey();
         bool keyIsLowercase = (iniUnescapedKey(data, lineStart, keyEnd, key) && sectionIsLowercase);
 
-        QString strValue;
-        strValue.reserve(lineLen - (valueStart - lineStart));
-        bool isStringList = iniUnescapedStringList(data, valueStart, lineStart + lineLen,
-                                                   strValue, strListValue/*, codec*/);
-        QVariant variant;
-        if (isStringList) {
-            variant = stringListToVariantList(strListValue);
-        } else {
-            variant = stringToVariant(strValue);
-        }
-
         /*
             We try to avoid the expensive toLower() call in
             QSettingsKey by passing Qt::CaseSensitive when the
             key is already in lowercase.
         */
-        settingsMap->insert(QSettingsKey(key, keyIsLowercase ? Qt::CaseSensitive
-                                                             : IniCaseSensitivity,
-                                         position),
-                            variant);
+        iniSectionEntry(target, key, keyIsLowercase ? Qt::CaseSensitive : cs, position,
+                        data, valueStart, lineStart + lineLen, strListValue);
         ++position;
+        return true;
     }
 
-    return ok;
-}
-bool readIniFile(const QByteArray &data,
-            UnparsedSettingsMap *unparsedIniSections)
+    bool isOk() const { return ok; }
+    int bytesConsumed() const { return dataPos; }
+
+private:
+    const QSettingsKey section;
+    const QByteArray data;
+    Target *target;
+    QStringList strListValue;
+    const Qt::CaseSensitivity cs;
+    bool sectionIsLowercase;
+    int dataPos;
+    int position;
+    bool ok;
+};
+
+template <typename Target>
+bool readIniSection(const QSettingsKey &section, const QByteArray &data,
+               Target *target, Qt::CaseSensitivity cs = IniCaseSensitivity)
 {
-#define FLUSH_CURRENT_SECTION() \
-    { \
-            QByteArray &sectionData = (*unparsedIniSections)[QSettingsKey(currentSection, \
-                                                  IniCaseSensitivity, \
-                                                  sectionPosition)]; \
-            if (!sectionData.isEmpty()) \
-            sectionData.append('\n'); \
-            sectionData += data.mid(currentSectionStart, lineStart - currentSectionStart); \
-            sectionPosition = ++position; \
+    IniSectionParser<Target> parser(section, data, target, cs);
+    while (parser.next()) {
     }
+    return parser.isOk();
+}
+/*
+    Restricts a read to some sections, or to the keys under some prefixes.
+    readIniFile drops every section that cannot contribute right after the
+    split, so it is neither copied nor parsed; wantsKey() then only has to
+    sort out single keys in sections that overlap a prefix partially.
+*/
+class IniProjection
+{
+public:
+    enum Mode { Sections, KeyPrefixes };
 
-    QString currentSection;
-    int currentSectionStart = 0;
-    int dataPos = 0;
-    int lineStart;
-    int lineLen;
-    int equalsPos;
-    int position = 0;
-    int sectionPosition = 0;
-    bool ok = true;
+    IniProjection(Mode mode, const QStringList &names)
+        : mode(mode)
+    {
+        for (const QString &name : names) {
+            if (mode == Sections)
+                sectionKeys.insert(name.isEmpty() ? name : name + QLatin1Char('/'));
+            else
+                prefixes.append(name);
+        }
+    }
 
-    while (readIniLine(data, dataPos, lineStart, lineLen, equalsPos)) {
-        char ch = data.at(lineStart);
+    // section is given as it prefixes its keys: with a trailing '/', or empty for General
+    bool wantsSection(const QString &section) const
+    {
+        if (mode == Sections)
+            return sectionKeys.contains(section);
+        for (const QString &prefix : prefixes) {
+            if (section.startsWith(prefix) || prefix.startsWith(section))
+                return true;
+        }
+        return false;
+    }
+
+    bool wantsKey(const QString &key) const
+    {
+        if (mode == Sections)
+            return true;
+        for (const QString &prefix : prefixes) {
+            if (key.startsWith(prefix))
+                return true;
+        }
+        return false;
+    }
+
+private:
+    Mode mode;
+    QSet<QString> sectionKeys;
+    QStringList prefixes;
+};
+
+template <typename SectionMap>
+class IniFileSplitter
+{
+public:
+    IniFileSplitter(const QByteArray &data, SectionMap *unparsedIniSections,
+                    const IniProjection *projection = nullptr,
+                    Qt::CaseSensitivity cs = IniCaseSensitivity)
+        : data(data), unparsedIniSections(unparsedIniSections), projection(projection), cs(cs),
+          currentSectionIsLowercase(true), currentSectionStart(0), dataPos(0), lineStart(0),
+          position(0), sectionPosition(0),
+          ok(true), done(false) {}
+
+    // splits off one line; false once the whole input is done
+    bool next()
+    {
+        if (done)
+            return false;
+
+        int lineLen;
+        int equalsPos;
+        if (!readIniLine(data, dataPos, lineStart, lineLen, equalsPos)) {
+            Q_ASSERT(lineStart == data.length());
+            flushCurrentSection();
+            done = true;
+            return false;
+        }
+
+        char ch = data.at(lineStart);
         if (ch == '[') {
-            FLUSH_CURRENT_SECTION();
+            flushCurrentSection();
 
             // this is a section
             QByteArray iniSection;
@@ -840,28 +1453,180 @@ bool readIniFile(const QByteArray &data,
 
             iniSection = iniSection.trimmed();
 
+            currentSectionIsLowercase = true;
             if (qstricmp(iniSection.constData(), "general") == 0) {
                 currentSection.clear();
             } else {
                 if (qstricmp(iniSection.constData(), "%general") == 0) {
                     currentSection = QLatin1String(iniSection.constData() + 1);
+                    currentSectionIsLowercase = (currentSection == QLatin1String("general"));
                 } else {
                     currentSection.clear();
-                    iniUnescapedKey(iniSection, 0, iniSection.size(), currentSection);
+                    currentSectionIsLowercase = iniUnescapedKey(iniSection, 0, iniSection.size(),
+                                                                currentSection);
                 }
                 currentSection += QLatin1Char('/');
             }
             currentSectionStart = dataPos;
         }
         ++position;
+        return true;
     }
 
-    Q_ASSERT(lineStart == data.length());
-    FLUSH_CURRENT_SECTION();
+    bool isOk() const { return ok; }
+    int bytesConsumed() const { return dataPos; }
 
-    return ok;
+private:
+    void flushCurrentSection()
+    {
+        if (!projection || projection->wantsSection(currentSection)) {
+            QByteArray &sectionData = (*unparsedIniSections)[QSettingsKey(currentSection,
+                                                  currentSectionIsLowercase ? Qt::CaseSensitive : cs,
+                                                  sectionPosition)];
+            if (!sectionData.isEmpty())
+                sectionData.append('\n');
+            sectionData += data.mid(currentSectionStart, lineStart - currentSectionStart);
+        }
+        sectionPosition = ++position;
+    }
 
-#undef FLUSH_CURRENT_SECTION
+    const QByteArray data;
+    SectionMap *unparsedIniSections;
+    const IniProjection *projection;
+    const Qt::CaseSensitivity cs;
+    QString currentSection;
+    bool currentSectionIsLowercase;
+    int currentSectionStart;
+    int dataPos;
+    int lineStart;
+    int position;
+    int sectionPosition;
+    bool ok;
+    bool done;
+};
+
+template <typename SectionMap>
+bool readIniFile(const QByteArray &data,
+            SectionMap *unparsedIniSections, const IniProjection *projection = nullptr,
+            Qt::CaseSensitivity cs = IniCaseSensitivity)
+{
+    IniFileSplitter<SectionMap> splitter(data, unparsedIniSections, projection, cs);
+    while (splitter.next()) {
+    }
+    return splitter.isOk();
+}
+
+/*
+    Marks one internal stage for a Qt5IniImpl::StageObserver. Without an
+    observer this is a single pointer test per stage, not per key. Stages
+    run on other threads (pool helpers, concurrent callers) are not
+    reported, so the observer never sees concurrent calls.
+*/
+static Qt5IniImpl::StageObserver *stageObserver = nullptr;
+static QThread *stageObserverThread = nullptr;
+
+class IniStage
+{
+public:
+    explicit IniStage(const char *name)
+        : name(stageObserver && QThread::currentThread() == stageObserverThread ? name : nullptr)
+    {
+        if (this->name)
+            stageObserver->stageBegin(this->name);
+    }
+    ~IniStage() { end(); }
+
+    void end()
+    {
+        if (name && stageObserver)
+            stageObserver->stageEnd(name);
+        name = nullptr;
+    }
+
+private:
+    Q_DISABLE_COPY(IniStage)
+    const char *name;
+};
+
+/*
+    The syntax checks behind Qt5IniImpl::CheckSyntax. They walk the same
+    lines as readIniFile and readIniSection and look at keys and values the
+    way iniUnescapedKey and iniUnescapedStringList would, but never build a
+    key or a value.
+*/
+static inline void iniReportIssue(QVector<Qt5IniImpl::SyntaxIssue> *issues,
+                                  Qt5IniImpl::SyntaxIssueKind kind, int offset)
+{
+    Qt5IniImpl::SyntaxIssue issue;
+    issue.kind = kind;
+    issue.offset = offset;
+    issues->append(issue);
+}
+
+// data[i] is a '%'; true if it starts a %XX or %UXXXX escape
+static bool iniKeyEscapeIsValid(const char *data, int i, int to)
+{
+    if (i == to - 1)
+        return false;
+
+    int numDigits = 2;
+    int firstDigitPos = i + 1;
+    if (data[i + 1] == 'U') {
+        ++firstDigitPos;
+        numDigits = 4;
+    }
+    if (firstDigitPos + numDigits > to)
+        return false;
+
+    for (int k = firstDigitPos; k < firstDigitPos + numDigits; ++k) {
+        if (hexDigitValue(data[k]) < 0)
+            return false;
+    }
+    return true;
+}
+
+static void iniCheckKey(const char *data, int from, int to, QVector<Qt5IniImpl::SyntaxIssue> *issues)
+{
+    const void *percent;
+    while (from < to && (percent = memchr(data + from, '%', size_t(to - from)))) {
+        const int i = int(static_cast<const char *>(percent) - data);
+        if (!iniKeyEscapeIsValid(data, i, to))
+            iniReportIssue(issues, Qt5IniImpl::BadKeyEscape, i);
+        from = i + 1;
+    }
+}
+
+static void iniCheckValue(const char *data, int from, int to, QVector<Qt5IniImpl::SyntaxIssue> *issues)
+{
+    int quoteStart = -1;
+    int i = iniFindValueDelimiter(data, from, to);
+    while (i < to) {
+        const char ch = data[i];
+        if (ch == '"') {
+            quoteStart = (quoteStart == -1) ? i : -1;
+            ++i;
+        } else if (ch == '\\') {
+            if (i + 1 == to) {
+                iniReportIssue(issues, Qt5IniImpl::BadValueEscape, i);
+                break;
+            }
+            const uchar esc = escapeDispatch[uchar(data[i + 1])];
+            if (esc == EscHex) {
+                // "\x" without a hex digit decodes to nothing at all
+                if (i + 2 == to || hexDigitValue(data[i + 2]) < 0)
+                    iniReportIssue(issues, Qt5IniImpl::BadValueEscape, i);
+            } else if (esc == 0) {
+                iniReportIssue(issues, Qt5IniImpl::UnknownValueEscape, i);
+            }
+            i += 2;
+        } else {
+            ++i;
+        }
+        i = iniFindValueDelimiter(data, i, to);
+    }
+
+    if (quoteStart != -1)
+        iniReportIssue(issues, Qt5IniImpl::UnterminatedQuote, quoteStart);
 }
 
 class QSettingsIniKey : public QString
@@ -893,21 +1658,174 @@ struct QSettingsIniSection
 
 typedef QMap<QString, QSettingsIniSection> IniMap;
 
+#ifdef Q_OS_WIN
+static const char * const iniEol = "\r\n";
+#else
+static const char iniEol = '\n';
+#endif
+
+static void iniAppendSectionHeader(const QString &section, bool first, QByteArray &result)
+{
+    QByteArray realSection;
+
+    iniEscapedKey(section, realSection);
+
+    if (realSection.isEmpty()) {
+        realSection = "[General]";
+    } else if (qstricmp(realSection.constData(), "general") == 0) {
+        realSection = "[%General]";
+    } else {
+        realSection.prepend('[');
+        realSection.append(']');
+    }
+
+    if (!first)
+        result += iniEol;
+    result += realSection;
+    result += iniEol;
+}
+
+static void iniAppendEntry(const QSettingsIniKey &key, const QVariant &value, QByteArray &block,
+                           Qt5IniWriteOptions options)
+{
+    iniEscapedKey(key, block);
+    block += '=';
+
+    /*
+        The size() != 1 trick is necessary because
+        QVariant(QString("foo")).toList() returns an empty
+        list, not a list containing "foo".
+    */
+    if (value.type() == QVariant::StringList) {
+        iniEscapedStringList(value.toStringList(), block/*, iniCodec*/);
+    } else if (value.type() == QVariant::List && value.toList().size() != 1) {
+        iniEscapedVariantList(value.toList(), block, options/*, iniCodec*/);
+    } else {
+        iniEscapedString(variantToString(value, options), block/*, iniCodec*/);
+    }
+    block += iniEol;
+}
+
+/*
+    The parallel writer cuts the ordered sections into runs of at most
+    ParallelWriteChunkSize keys, serializes the runs on the global thread
+    pool and writes them in order, so the output is the same as the serial
+    one. The calling thread takes chunks as well instead of idling, and the
+    pool threads outlive the call, which keeps their escapedKeyCache warm.
+    Below ParallelWriteMinKeys keys the threads cost more than they save.
+*/
+static const int ParallelWriteMinKeys = 4096;
+static const int ParallelWriteChunkSize = 1024;
+
+struct IniWriteChunk
+{
+    IniKeyMap::const_iterator begin;
+    IniKeyMap::const_iterator end;
+    QByteArray bytes;
+};
+
+/*
+    Shared by the caller and its helpers. A helper that only gets to run
+    after all chunks are taken finds nothing left and returns without
+    touching the chunks, so the caller may return once every chunk is
+    done even while such helpers are still queued.
+*/
+struct IniWriteJob
+{
+    explicit IniWriteJob(Qt5IniWriteOptions options) : options(options) {}
+
+    // serializes chunks until none is left
+    void work()
+    {
+        const int chunkCount = chunks.size();
+        int k;
+        while ((k = nextChunk.fetchAndAddRelaxed(1)) < chunkCount) {
+            IniWriteChunk &chunk = chunks[k];
+            for (IniKeyMap::const_iterator j = chunk.begin; j != chunk.end; ++j)
+                iniAppendEntry(j.key(), j.value(), chunk.bytes, options);
+            chunksDone.release();
+        }
+    }
+
+    QVector<IniWriteChunk> chunks;
+    QAtomicInt nextChunk;
+    QSemaphore chunksDone;
+    const Qt5IniWriteOptions options;
+};
+
+class IniWriteWorker : public QRunnable
+{
+public:
+    explicit IniWriteWorker(const std::shared_ptr<IniWriteJob> &job)
+        : job(job) {}
+
+    void run() override
+    {
+        job->work();
+    }
+
+private:
+    std::shared_ptr<IniWriteJob> job;
+};
+
+static bool writeIniSectionsParallel(QIODevice &device, const IniMap &iniMap,
+                                     const QVector<QSettingsIniKey> &sections,
+                                     Qt5IniWriteOptions options)
+{
+    std::shared_ptr<IniWriteJob> job = std::make_shared<IniWriteJob>(options);
+    QVector<IniWriteChunk> &chunks = job->chunks;
+    for (int s = 0; s < sections.size(); ++s) {
+        IniMap::const_iterator i = iniMap.constFind(sections.at(s));
+        Q_ASSERT(i != iniMap.constEnd());
+
+        const IniKeyMap &ents = i.value().keyMap;
+        IniKeyMap::const_iterator begin = ents.constBegin();
+        bool first = true;
+        do {
+            IniWriteChunk chunk;
+            chunk.begin = begin;
+            chunk.end = begin;
+            for (int n = 0; n < ParallelWriteChunkSize && chunk.end != ents.constEnd(); ++n)
+                ++chunk.end;
+            if (first)
+                iniAppendSectionHeader(i.key(), s == 0, chunk.bytes);
+            chunks.append(chunk);
+
+            begin = chunk.end;
+            first = false;
+        } while (begin != ents.constEnd());
+    }
+
+    // helpers only where the pool has idle threads; the caller covers the rest
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int helperCount = qMin(chunks.size(), QThread::idealThreadCount()) - 1;
+    for (int t = 0; t < helperCount; ++t) {
+        IniWriteWorker *worker = new IniWriteWorker(job);
+        if (!pool->tryStart(worker)) {
+            delete worker;
+            break;
+        }
+    }
+    job->work();
+    job->chunksDone.acquire(chunks.size());
+
+    for (int k = 0; k < chunks.size(); ++k) {
+        if (device.write(chunks.at(k).bytes) == -1)
+            return false;
+    }
+    return true;
+}
+
 /*
     This would be more straightforward if we didn't try to remember the original
     key order in the .ini file, but we do.
 */
-bool writeIniFile(QIODevice &device, const ParsedSettingsMap &map)
+bool writeIniFile(QIODevice &device, const ParsedSettingsMap &map, Qt5IniWriteOptions options)
 {
+    IniStage groupStage("iniMap");
     IniMap iniMap;
     IniMap::const_iterator i;
 
-#ifdef Q_OS_WIN
-    const char * const eol = "\r\n";
-#else
-    const char eol = '\n';
-#endif
-
     for (ParsedSettingsMap::const_iterator j = map.constBegin(); j != map.constEnd(); ++j) {
         QString section;
         QSettingsIniKey key(j.key().originalCaseKey(), j.key().originalKeyPosition());
@@ -932,6 +1850,13 @@ bool writeIniFile(QIODevice &device, const ParsedSettingsMap &map)
     for (i = iniMap.constBegin(); i != iniMap.constEnd(); ++i)
         sections.append(QSettingsIniKey(i.key(), i.value().position));
     std::sort(sections.begin(), sections.end());
+    groupStage.end();
+
+    IniStage serializeStage("serialize");
+    if ((options & Qt5IniParallelWrite) && map.size() >= ParallelWriteMinKeys
+        && QThread::idealThreadCount() > 1) {
+        return writeIniSectionsParallel(device, iniMap, sections, options);
+    }
 
     bool writeError = false;
     for (int j = 0; !writeError && j < sectionCount; ++j) {
@@ -939,44 +1864,13 @@ bool writeIniFile(QIODevice &device, const ParsedSettingsMap &map)
         Q_ASSERT(i != iniMap.constEnd());
 
         QByteArray realSection;
-
-        iniEscapedKey(i.key(), realSection);
-
-        if (realSection.isEmpty()) {
-            realSection = "[General]";
-        } else if (qstricmp(realSection.constData(), "general") == 0) {
-            realSection = "[%General]";
-        } else {
-            realSection.prepend('[');
-            realSection.append(']');
-        }
-
-        if (j != 0)
-            realSection.prepend(eol);
-        realSection += eol;
-
+        iniAppendSectionHeader(i.key(), j == 0, realSection);
         device.write(realSection);
 
         const IniKeyMap &ents = i.value().keyMap;
         for (IniKeyMap::const_iterator j = ents.constBegin(); j != ents.constEnd(); ++j) {
             QByteArray block;
-            iniEscapedKey(j.key(), block);
-            block += '=';
-
-            const QVariant &value = j.value();
-
-            /*
-                The size() != 1 trick is necessary because
-                QVariant(QString("foo")).toList() returns an empty
-                list, not a list containing "foo".
-            */
-            if (value.type() == QVariant::StringList
-                || (value.type() == QVariant::List && value.toList().size() != 1)) {
-                iniEscapedStringList(variantListToStringList(value.toList()), block/*, iniCodec*/);
-            } else {
-                iniEscapedString(variantToString(value), block/*, iniCodec*/);
-            }
-            block += eol;
+            iniAppendEntry(j.key(), j.value(), block, options);
             if (device.write(block) == -1) {
                 writeError = true;
                 break;
@@ -986,13 +1880,14 @@ bool writeIniFile(QIODevice &device, const ParsedSettingsMap &map)
     return !writeError;
 }
 
-bool ensureAllSectionsParsed(UnparsedSettingsMap & unparsedIniSections, ParsedSettingsMap & originalKeys)
+bool ensureAllSectionsParsed(UnparsedSettingsMap & unparsedIniSections, ParsedSettingsMap & originalKeys,
+                             Qt::CaseSensitivity cs = IniCaseSensitivity)
 {
     UnparsedSettingsMap::const_iterator i = unparsedIniSections.constBegin();
     const UnparsedSettingsMap::const_iterator end = unparsedIniSections.constEnd();
 
     for (; i != end; ++i) {
-        if (!readIniSection(i.key(), i.value(), &originalKeys)){
+        if (!readIniSection(i.key(), i.value(), &originalKeys, cs)){
             return false;
         }
     }
@@ -1001,30 +1896,319 @@ bool ensureAllSectionsParsed(UnparsedSettingsMap & unparsedIniSections, ParsedSe
 }
 
 bool Qt5IniImpl::ReadFunc(QIODevice &device, QSettings::SettingsMap &map)
+{
+    IniStage readStage("readAll");
+    const QByteArray data = device.readAll();
+    readStage.end();
+
+    return ReadData(data, map);
+}
+
+static bool iniReadData(const QByteArray &data, QSettings::SettingsMap &map,
+                        const IniProjection *projection,
+                        Qt::CaseSensitivity cs = IniCaseSensitivity,
+                        QHash<QString, QString> *originalKeys = nullptr)
 {
     UnparsedSettingsMap tmpIniSections;
-    if(!readIniFile(device.readAll(), &tmpIniSections)){
+    IniStage splitStage("readIniFile");
+    if(!readIniFile(data, &tmpIniSections, projection, cs)){
         return false;
     }
+    splitStage.end();
+
     ParsedSettingsMap outmap;
-    if(!ensureAllSectionsParsed(tmpIniSections, outmap)){
+    IniStage parseStage("readIniSection");
+    if(!ensureAllSectionsParsed(tmpIniSections, outmap, cs)){
         return false;
     }
+    parseStage.end();
+
+    IniStage copyStage("mapCopy");
     ParsedSettingsMap::const_iterator i = outmap.constBegin();
     while (i != outmap.constEnd()) {
-        map.insert(i.key(), i.value());
+        if (!projection || projection->wantsKey(i.key())) {
+            map.insert(i.key(), i.value());
+            if (originalKeys && i.key().wasFolded())
+                originalKeys->insert(i.key(), i.key().originalCaseKey());
+        }
         ++i;
     }
     return true;
 }
 
+void Qt5IniImpl::SetStageObserver(StageObserver *observer)
+{
+    stageObserverThread = observer ? QThread::currentThread() : nullptr;
+    stageObserver = observer;
+}
+
+bool Qt5IniImpl::ReadData(const QByteArray &data, QSettings::SettingsMap &map)
+{
+    return iniReadData(data, map, nullptr);
+}
+
+bool Qt5IniImpl::ReadDataCaseInsensitive(const QByteArray &data, QSettings::SettingsMap &map,
+                                         QHash<QString, QString> &originalKeys)
+{
+    return iniReadData(data, map, nullptr, Qt::CaseInsensitive, &originalKeys);
+}
+
+QString Qt5IniImpl::GroupPrefix(const QString &group)
+{
+    if (group.isEmpty() || group.endsWith(QLatin1Char('/')))
+        return group;
+    return group + QLatin1Char('/');
+}
+
+QString Qt5IniImpl::FoldKey(const QString &key)
+{
+    const QChar *chars = key.constData();
+    const int size = key.size();
+    for (int i = 0; i < size; ++i) {
+        const ushort c = chars[i].unicode();
+        if (c < 0x80 ? (c >= 'A' && c <= 'Z') : chars[i].toLower() != chars[i])
+            return key.toLower();
+    }
+    return key;
+}
+
+struct Qt5IniImpl::IncrementalReader::State
+{
+    enum Phase { Splitting, Parsing, Finished };
+
+    explicit State(const QByteArray &data)
+        : splitter(data, &sections), phase(Splitting), ok(true), dataSize(data.size()),
+          parsedBytes(0) {}
+
+    UnparsedSettingsMap sections;
+    IniFileSplitter<UnparsedSettingsMap> splitter;
+    UnparsedSettingsMap::iterator section;
+    std::unique_ptr<IniSectionParser<QSettings::SettingsMap> > sectionParser;
+    QSettings::SettingsMap map;
+    Phase phase;
+    bool ok;
+    qint64 dataSize;
+    qint64 parsedBytes;
+};
+
+Qt5IniImpl::IncrementalReader::IncrementalReader(const QByteArray &data)
+    : d(new State(data))
+{
+}
+
+Qt5IniImpl::IncrementalReader::~IncrementalReader()
+{
+}
+
+/*
+    The same stages as ReadData: first the whole input is split into
+    sections, then the sections are parsed one line at a time straight into
+    the result map, each one released as soon as it is done. On failure the
+    map is left empty, just like ReadFunc leaves it.
+*/
+bool Qt5IniImpl::IncrementalReader::step(int byteBudget)
+{
+    State &s = *d;
+    const qint64 target = bytesProcessed() + qMax(byteBudget, 1);
+
+    while (s.phase != State::Finished && bytesProcessed() < target) {
+        if (s.phase == State::Splitting) {
+            if (s.splitter.next())
+                continue;
+            if (!s.splitter.isOk()) {
+                s.ok = false;
+                s.sections.clear();
+                s.phase = State::Finished;
+                break;
+            }
+            s.section = s.sections.begin();
+            s.phase = State::Parsing;
+        }
+
+        if (s.section == s.sections.end()) {
+            s.phase = State::Finished;
+            break;
+        }
+
+        if (!s.sectionParser)
+            s.sectionParser.reset(new IniSectionParser<QSettings::SettingsMap>(s.section.key(), s.section.value(), &s.map));
+        if (s.sectionParser->next())
+            continue;
+
+        if (!s.sectionParser->isOk()) {
+            s.ok = false;
+            s.map.clear();
+            s.sections.clear();
+            s.sectionParser.reset();
+            s.phase = State::Finished;
+            break;
+        }
+        s.parsedBytes += s.section.value().size();
+        s.sectionParser.reset();
+        s.section = s.sections.erase(s.section);
+    }
+
+    return s.phase == State::Finished;
+}
+
+bool Qt5IniImpl::IncrementalReader::isFinished() const
+{
+    return d->phase == State::Finished;
+}
+
+bool Qt5IniImpl::IncrementalReader::ok() const
+{
+    return d->ok;
+}
+
+qint64 Qt5IniImpl::IncrementalReader::bytesProcessed() const
+{
+    qint64 bytes = d->splitter.bytesConsumed() + d->parsedBytes;
+    if (d->sectionParser)
+        bytes += d->sectionParser->bytesConsumed();
+    return bytes;
+}
+
+qint64 Qt5IniImpl::IncrementalReader::estimatedTotalBytes() const
+{
+    // every byte is looked at once by the splitter and, mostly, once more by a section parser
+    return 2 * d->dataSize;
+}
+
+const QSettings::SettingsMap &Qt5IniImpl::IncrementalReader::map() const
+{
+    return d->map;
+}
+
+bool Qt5IniImpl::ReadSectionsOnly(QIODevice &device, QSettings::SettingsMap &map,
+                                  const QStringList &sections)
+{
+    const IniProjection projection(IniProjection::Sections, sections);
+    return iniReadData(device.readAll(), map, &projection);
+}
+
+bool Qt5IniImpl::ReadKeyPrefixes(QIODevice &device, QSettings::SettingsMap &map,
+                                 const QStringList &keyPrefixes)
+{
+    const IniProjection projection(IniProjection::KeyPrefixes, keyPrefixes);
+    return iniReadData(device.readAll(), map, &projection);
+}
+
+bool Qt5IniImpl::ReadSections(const QByteArray &data, SectionMap &sections)
+{
+    return readIniFile(data, &sections);
+}
+
+bool Qt5IniImpl::ReadSection(const QString &section, const QByteArray &data, QSettings::SettingsMap &map)
+{
+    return readIniSection(QSettingsKey(section, IniCaseSensitivity), data, &map);
+}
+
+bool Qt5IniImpl::ReadRawSection(const QString &section, const QByteArray &data, QVector<RawEntry> &entries)
+{
+    return readIniSection(QSettingsKey(section, IniCaseSensitivity), data, &entries);
+}
+
+QVariant Qt5IniImpl::DecodeValue(const QByteArray &data, int from, int to)
+{
+    QStringList strListValue;
+    return iniValueToVariant(data, from, to, strListValue);
+}
+
+bool Qt5IniImpl::ReadLine(const QByteArray &data, int &dataPos, int &lineStart, int &lineLen, int &equalsPos)
+{
+    return readIniLine(data, dataPos, lineStart, lineLen, equalsPos);
+}
+
+bool Qt5IniImpl::UnescapeKey(const QByteArray &key, int from, int to, QString &result)
+{
+    return iniUnescapedKey(key, from, to, result);
+}
+
+int Qt5IniImpl::KeyEscapeValue(const char *digits, int numDigits, bool *ok)
+{
+    return iniKeyEscapeValue(digits, numDigits, ok);
+}
+
+bool Qt5IniImpl::UnescapeValue(const QByteArray &data, int from, int to,
+                               QString &stringResult, QStringList &stringListResult)
+{
+    return iniUnescapedStringList(data, from, to, stringResult, stringListResult);
+}
+
+bool Qt5IniImpl::CheckSyntax(const QByteArray &data, QVector<SyntaxIssue> *issues)
+{
+    const char *raw = data.constData();
+    int dataPos = 0;
+    int lineStart;
+    int lineLen;
+    int equalsPos;
+    bool ok = true;
+
+    while (readIniLine(data, dataPos, lineStart, lineLen, equalsPos)) {
+        const int lineEnd = lineStart + lineLen;
+        const char ch = raw[lineStart];
+
+        if (ch == '[') {
+            const void *close = memchr(raw + lineStart, ']', size_t(lineLen));
+            int nameEnd = lineEnd;
+            if (close) {
+                nameEnd = int(static_cast<const char *>(close) - raw);
+            } else {
+                ok = false;
+                if (issues)
+                    iniReportIssue(issues, UnterminatedSectionHeader, lineStart);
+            }
+
+            if (issues) {
+                int nameStart = lineStart + 1;
+                while (nameStart < nameEnd && (charTraits[uint(uchar(raw[nameStart]))] & Space))
+                    ++nameStart;
+                while (nameEnd > nameStart && (charTraits[uint(uchar(raw[nameEnd - 1]))] & Space))
+                    --nameEnd;
+                // "[%General]" is how a section literally named "General" is written
+                if (!(nameEnd - nameStart == 8 && qstrnicmp(raw + nameStart, "%general", 8) == 0))
+                    iniCheckKey(raw, nameStart, nameEnd, issues);
+            }
+        } else if (equalsPos == -1) {
+            if (ch != ';') {
+                ok = false;
+                if (issues)
+                    iniReportIssue(issues, MissingEquals, lineStart);
+            }
+        } else if (issues) {
+            int keyEnd = equalsPos;
+            char c;
+            while (keyEnd > lineStart && ((c = raw[keyEnd - 1]) == ' ' || c == '\t'))
+                --keyEnd;
+            if (keyEnd == lineStart)
+                iniReportIssue(issues, EmptyKey, lineStart);
+            iniCheckKey(raw, lineStart, keyEnd, issues);
+            iniCheckValue(raw, equalsPos + 1, lineEnd, issues);
+        }
+
+        // without an issue list the first error settles the result
+        if (!ok && !issues)
+            return false;
+    }
+    return ok;
+}
+
 bool Qt5IniImpl::WriteFunc(QIODevice &device, const QSettings::SettingsMap &map)
 {
+    return WriteFunc(device, map, Qt5IniWriteOptions());
+}
+
+bool Qt5IniImpl::WriteFunc(QIODevice &device, const QSettings::SettingsMap &map, Qt5IniWriteOptions options)
+{
+    IniStage tmpMapStage("tmpMap");
     ParsedSettingsMap tmpMap;
     QSettings::SettingsMap::const_iterator it = map.constBegin();
     while(it != map.constEnd()){
         tmpMap.insert(QSettingsKey(it.key(), IniCaseSensitivity), it.value());
         ++it;
     }
-    return writeIniFile(device, tmpMap);
+    tmpMapStage.end();
+
+    return writeIniFile(device, tmpMap, options);
 }
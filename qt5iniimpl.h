@@ -34,10 +34,150 @@
 #ifndef QT5INIIMPL_H
 #define QT5INIIMPL_H
 #include <QSettings>
+#include <QHash>
+#include <QVector>
+#include <memory>
+#include "qt5iniformat.h"
 
 namespace Qt5IniImpl{
     bool ReadFunc(QIODevice & device, QSettings::SettingsMap & map);
     bool WriteFunc(QIODevice & device, const QSettings::SettingsMap &map);
+    bool WriteFunc(QIODevice & device, const QSettings::SettingsMap &map, Qt5IniWriteOptions options);
+
+    // ReadFunc on data that is already in memory
+    bool ReadData(const QByteArray &data, QSettings::SettingsMap &map);
+
+    /*
+        ReadData with keys compared case-insensitively, the way QSettings
+        treats INI files on Windows. Every key is folded to lowercase once
+        while parsing, and keys the parser already knows to be lowercase are
+        not folded at all. map holds the folded keys; originalKeys maps each
+        folded key whose spelling in the file differs back to that spelling,
+        for writing the file again. Of keys that fold to the same string the
+        last value wins and the first spelling is kept.
+    */
+    bool ReadDataCaseInsensitive(const QByteArray &data, QSettings::SettingsMap &map,
+                                 QHash<QString, QString> &originalKeys);
+    // the lookup form of a key for maps from ReadDataCaseInsensitive; no copy if it is lowercase
+    QString FoldKey(const QString &key);
+
+    /*
+        ReadFunc restricted to whole sections (by group name, "" for
+        General) or to keys starting with one of the given prefixes.
+        Sections that cannot contain a wanted key are skipped right after
+        the section split and never parsed, so malformed lines in them are
+        not reported either.
+    */
+    bool ReadSectionsOnly(QIODevice &device, QSettings::SettingsMap &map, const QStringList &sections);
+    bool ReadKeyPrefixes(QIODevice &device, QSettings::SettingsMap &map, const QStringList &keyPrefixes);
+
+    /*
+        ReadData in small steps. Every step() handles whole lines until at
+        least byteBudget bytes were processed and returns true once the
+        input is done; map() is then what ReadData would have produced.
+    */
+    class IncrementalReader
+    {
+    public:
+        explicit IncrementalReader(const QByteArray &data);
+        ~IncrementalReader();
+
+        bool step(int byteBudget);
+        bool isFinished() const;
+        bool ok() const;
+
+        qint64 bytesProcessed() const;
+        qint64 estimatedTotalBytes() const;
+
+        const QSettings::SettingsMap &map() const;
+
+    private:
+        Q_DISABLE_COPY(IncrementalReader)
+
+        struct State;
+        std::unique_ptr<State> d;
+    };
+
+    /*
+        The two stages of ReadFunc, for callers that want to work on one
+        section at a time. Section names carry their trailing '/' (the
+        General section is the empty string), exactly as they prefix keys.
+    */
+    typedef QMap<QString, QByteArray> SectionMap;
+    bool ReadSections(const QByteArray &data, SectionMap &sections);
+    bool ReadSection(const QString &section, const QByteArray &data, QSettings::SettingsMap &map);
+    // a group name as it prefixes its keys: with a trailing '/', or empty for the top level
+    QString GroupPrefix(const QString &group);
+
+    /*
+        For containers that keep values in their escaped form and decode
+        them on access: ReadRawSection only unescapes the keys and records
+        where each value's bytes are in data, DecodeValue turns such a byte
+        range into the QVariant ReadSection would have produced.
+    */
+    struct RawEntry
+    {
+        QString key;
+        int valueStart;
+        int valueEnd;
+    };
+    bool ReadRawSection(const QString &section, const QByteArray &data, QVector<RawEntry> &entries);
+    QVariant DecodeValue(const QByteArray &data, int from, int to);
+
+    // the line scanner and the key/value unescapers themselves
+    bool ReadLine(const QByteArray &data, int &dataPos, int &lineStart, int &lineLen, int &equalsPos);
+    bool UnescapeKey(const QByteArray &key, int from, int to, QString &result);
+    // the character a %XX (numDigits 2) or %UXXXX (numDigits 4) key escape stands for
+    int KeyEscapeValue(const char *digits, int numDigits, bool *ok);
+    bool UnescapeValue(const QByteArray &data, int from, int to,
+                       QString &stringResult, QStringList &stringListResult);
+
+    /*
+        Syntax checks without decoding anything. Every problem is reported
+        with the byte offset it starts at. UnterminatedSectionHeader and
+        MissingEquals are the lines that make ReadFunc fail, and the return
+        value is false exactly when ReadFunc would return false; the other
+        kinds are accepted by the reader but probably not what was meant.
+    */
+    enum SyntaxIssueKind
+    {
+        UnterminatedSectionHeader,
+        MissingEquals,
+        EmptyKey,
+        BadKeyEscape,
+        BadValueEscape,
+        UnknownValueEscape,
+        UnterminatedQuote
+    };
+    struct SyntaxIssue
+    {
+        SyntaxIssueKind kind;
+        int offset;
+    };
+    bool CheckSyntax(const QByteArray &data, QVector<SyntaxIssue> *issues);
+
+    /*
+        Hooks for measuring tools such as tools/qini-alloc. While an
+        observer is set, ReadFunc, ReadData, WriteFunc and the writer report
+        the start and end of their internal stages: "readAll", "readIniFile",
+        "readIniSection", "mapCopy", "tmpMap", "iniMap" and "serialize". The
+        observer is process wide and must only be changed while no INI data
+        is being read or written.
+
+        Only stages run on the thread that called SetStageObserver are
+        reported, so the observer is never called concurrently and needs no
+        locking. Work done on other threads is not seen, such as the
+        sections Qt5IniParallelWrite hands to pool threads or the files the
+        batch and layered loaders read on pool threads.
+    */
+    class StageObserver
+    {
+    public:
+        virtual ~StageObserver() {}
+        virtual void stageBegin(const char *stage) = 0;
+        virtual void stageEnd(const char *stage) = 0;
+    };
+    void SetStageObserver(StageObserver *observer);
 };
 
 #endif // QT5INIIMPL_H
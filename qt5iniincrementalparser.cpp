@@ -0,0 +1,111 @@
+#include "qt5iniincrementalparser.h"
+#include "qt5iniimpl.h"
+#include <QElapsedTimer>
+#include <QTimer>
+
+// how much a time-limited step parses between two looks at the clock
+static const int StepSliceBytes = 16 * 1024;
+
+Qt5IniIncrementalParser::Qt5IniIncrementalParser(QObject *parent)
+    : QObject(parent), reader(new Qt5IniImpl::IncrementalReader(QByteArray())),
+      timer(new QTimer(this)), timeBudget(8), finishedEmitted(false)
+{
+    timer->setInterval(0);
+    connect(timer, &QTimer::timeout, this, &Qt5IniIncrementalParser::stepFromTimer);
+}
+
+Qt5IniIncrementalParser::~Qt5IniIncrementalParser()
+{
+}
+
+void Qt5IniIncrementalParser::setData(const QByteArray &data)
+{
+    reader.reset(new Qt5IniImpl::IncrementalReader(data));
+    finishedEmitted = false;
+}
+
+void Qt5IniIncrementalParser::setDevice(QIODevice &device)
+{
+    setData(device.readAll());
+}
+
+bool Qt5IniIncrementalParser::step(int timeBudgetMsecs)
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    bool done;
+    do {
+        done = reader->step(StepSliceBytes);
+    } while (!done && !elapsed.hasExpired(timeBudgetMsecs));
+
+    if (done)
+        emitFinishedOnce();
+    return done;
+}
+
+bool Qt5IniIncrementalParser::stepBytes(int byteBudget)
+{
+    const bool done = reader->step(byteBudget);
+    if (done)
+        emitFinishedOnce();
+    return done;
+}
+
+void Qt5IniIncrementalParser::start(int timeBudgetMsecs)
+{
+    timeBudget = timeBudgetMsecs;
+    if (!reader->isFinished())
+        timer->start();
+    else
+        emitFinishedOnce();
+}
+
+void Qt5IniIncrementalParser::stop()
+{
+    timer->stop();
+}
+
+bool Qt5IniIncrementalParser::isRunning() const
+{
+    return timer->isActive();
+}
+
+bool Qt5IniIncrementalParser::isFinished() const
+{
+    return reader->isFinished();
+}
+
+bool Qt5IniIncrementalParser::ok() const
+{
+    return reader->ok();
+}
+
+qreal Qt5IniIncrementalParser::progress() const
+{
+    if (reader->isFinished())
+        return 1.0;
+    const qint64 total = reader->estimatedTotalBytes();
+    if (total <= 0)
+        return 0.0;
+    return qMin(qreal(reader->bytesProcessed()) / total, qreal(1.0));
+}
+
+QSettings::SettingsMap Qt5IniIncrementalParser::map() const
+{
+    return reader->map();
+}
+
+void Qt5IniIncrementalParser::stepFromTimer()
+{
+    step(timeBudget);
+}
+
+void Qt5IniIncrementalParser::emitFinishedOnce()
+{
+    timer->stop();
+    if (finishedEmitted)
+        return;
+    finishedEmitted = true;
+    emit finished(reader->map(), reader->ok());
+}
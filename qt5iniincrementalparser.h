@@ -0,0 +1,60 @@
+#ifndef QT5INIINCREMENTALPARSER_H
+#define QT5INIINCREMENTALPARSER_H
+
+#include "Qt5IniFormat_global.h"
+#include <QObject>
+#include <QSettings>
+#include <QIODevice>
+#include <memory>
+
+class QTimer;
+namespace Qt5IniImpl { class IncrementalReader; }
+
+/*
+    Parses INI data in time slices on the thread it lives in, for event loop
+    threads that must stay responsive and cannot hand the work to another
+    thread. Each step() parses whole lines until the time or byte budget is
+    used up and then returns; start() runs one step per event loop pass from
+    a zero-interval timer. When the input is done, finished() delivers the
+    same map Qt5IniFormatReadFunc would have returned.
+*/
+class QT5INIFORMAT_EXPORT Qt5IniIncrementalParser : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Qt5IniIncrementalParser(QObject *parent = nullptr);
+    ~Qt5IniIncrementalParser() override;
+
+    // both reset the parser; setDevice() reads the whole device at once
+    void setData(const QByteArray &data);
+    void setDevice(QIODevice &device);
+
+    bool step(int timeBudgetMsecs);
+    bool stepBytes(int byteBudget);
+
+    void start(int timeBudgetMsecs = 8);
+    void stop();
+    bool isRunning() const;
+
+    bool isFinished() const;
+    bool ok() const;
+    qreal progress() const;
+    QSettings::SettingsMap map() const;
+
+signals:
+    void finished(const QVariantMap &map, bool ok);
+
+private slots:
+    void stepFromTimer();
+
+private:
+    void emitFinishedOnce();
+
+    std::unique_ptr<Qt5IniImpl::IncrementalReader> reader;
+    QTimer *timer;
+    int timeBudget;
+    bool finishedEmitted;
+};
+
+#endif // QT5INIINCREMENTALPARSER_H
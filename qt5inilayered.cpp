@@ -0,0 +1,228 @@
+#include "qt5inilayered.h"
+#include <QFile>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+
+static bool loadLayerFile(const QString &fileName, Qt5IniIncrementalReloader &reader,
+                          Qt5IniChangeSet *changes)
+{
+    QFile file(fileName);
+    if (!file.exists()) {
+        // a missing layer is an empty one, just like QSettings treats missing files
+        return reader.reload(QByteArray(), changes);
+    }
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    return reader.reload(file, changes);
+}
+
+class LayerLoadTask : public QRunnable
+{
+public:
+    LayerLoadTask(const QString &fileName, Qt5IniIncrementalReloader *reader, bool *ok)
+        : fileName(fileName), reader(reader), ok(ok) {}
+
+    void run() override
+    {
+        *ok = loadLayerFile(fileName, *reader, nullptr);
+    }
+
+private:
+    QString fileName;
+    Qt5IniIncrementalReloader *reader;
+    bool *ok;
+};
+
+Qt5IniLayeredConfig::Qt5IniLayeredConfig()
+{
+}
+
+int Qt5IniLayeredConfig::addLayer(const QString &fileName)
+{
+    Layer layer;
+    layer.fileName = fileName;
+    layers.append(layer);
+    return layers.size() - 1;
+}
+
+bool Qt5IniLayeredConfig::load()
+{
+    const int layerCount = layers.size();
+    QVector<bool> layerOk(layerCount, false);
+
+    if (layerCount == 1) {
+        layerOk[0] = loadLayerFile(layers[0].fileName, layers[0].reader, nullptr);
+    } else if (layerCount > 1) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(qMin(layerCount, QThread::idealThreadCount()));
+        for (int i = 0; i < layerCount; ++i)
+            pool.start(new LayerLoadTask(layers[i].fileName, &layers[i].reader, &layerOk[i]));
+        pool.waitForDone();
+    }
+
+    rebuild();
+    return !layerOk.contains(false);
+}
+
+bool Qt5IniLayeredConfig::reloadLayer(int layer, Qt5IniChangeSet *changes)
+{
+    Q_ASSERT(layer >= 0 && layer < layers.size());
+
+    if (changes)
+        changes->clear();
+
+    Qt5IniChangeSet layerChanges;
+    if (!loadLayerFile(layers[layer].fileName, layers[layer].reader, &layerChanges))
+        return false;
+    applyLayerChanges(layer, layerChanges, changes);
+    return true;
+}
+
+bool Qt5IniLayeredConfig::reloadLayer(int layer, const QByteArray &data, Qt5IniChangeSet *changes)
+{
+    Q_ASSERT(layer >= 0 && layer < layers.size());
+
+    if (changes)
+        changes->clear();
+
+    Qt5IniChangeSet layerChanges;
+    if (!layers[layer].reader.reload(data, &layerChanges))
+        return false;
+    applyLayerChanges(layer, layerChanges, changes);
+    return true;
+}
+
+bool Qt5IniLayeredConfig::contains(const QString &key) const
+{
+    return flat.contains(key);
+}
+
+QVariant Qt5IniLayeredConfig::value(const QString &key, const QVariant &defaultValue) const
+{
+    FlatMap::const_iterator it = flat.constFind(key);
+    if (it == flat.constEnd())
+        return defaultValue;
+    return it.value().value;
+}
+
+int Qt5IniLayeredConfig::layerOf(const QString &key) const
+{
+    FlatMap::const_iterator it = flat.constFind(key);
+    if (it == flat.constEnd())
+        return -1;
+    return it.value().layer;
+}
+
+QSettings::SettingsMap Qt5IniLayeredConfig::toSettingsMap() const
+{
+    QSettings::SettingsMap map;
+    for (FlatMap::const_iterator it = flat.constBegin(); it != flat.constEnd(); ++it)
+        map.insert(map.constEnd(), it.key(), it.value().value);
+    return map;
+}
+
+Qt5IniSnapshot Qt5IniLayeredConfig::snapshot() const
+{
+    return Qt5IniSnapshot(toSettingsMap());
+}
+
+/*
+    One sorted merge over all layers. On equal keys the highest layer wins;
+    every layer that holds the key advances past it.
+*/
+void Qt5IniLayeredConfig::rebuild()
+{
+    const int layerCount = layers.size();
+    QVector<QSettings::SettingsMap::const_iterator> its(layerCount);
+    QVector<QSettings::SettingsMap::const_iterator> ends(layerCount);
+    for (int l = 0; l < layerCount; ++l) {
+        its[l] = layers.at(l).reader.settingsMap().constBegin();
+        ends[l] = layers.at(l).reader.settingsMap().constEnd();
+    }
+
+    flat.clear();
+    forever {
+        int best = -1;
+        for (int l = 0; l < layerCount; ++l) {
+            if (its.at(l) == ends.at(l))
+                continue;
+            // a smaller key, or the same key from a higher layer
+            if (best == -1 || !(its.at(best).key() < its.at(l).key()))
+                best = l;
+        }
+        if (best == -1)
+            break;
+
+        const QString key = its.at(best).key();
+        FlatEntry entry;
+        entry.value = its.at(best).value();
+        entry.layer = best;
+        flat.insert(flat.constEnd(), key, entry);
+
+        for (int l = 0; l < layerCount; ++l) {
+            if (its.at(l) != ends.at(l) && its.at(l).key() == key)
+                ++its[l];
+        }
+    }
+}
+
+/*
+    Only keys that changed in the reloaded layer can change in the flattened
+    view, and only if no higher layer overrides them.
+*/
+void Qt5IniLayeredConfig::applyLayerChanges(int layer, const Qt5IniChangeSet &layerChanges,
+                                            Qt5IniChangeSet *changes)
+{
+    const QStringList *candidateLists[] = {
+        &layerChanges.added, &layerChanges.changed, &layerChanges.removed
+    };
+
+    for (const QStringList *candidates : candidateLists) {
+        for (const QString &key : *candidates) {
+            FlatMap::iterator it = flat.find(key);
+            if (it != flat.end() && it.value().layer > layer)
+                continue;
+
+            int provider = -1;
+            QVariant value;
+            for (int l = layer; l >= 0; --l) {
+                const QSettings::SettingsMap &map = layers.at(l).reader.settingsMap();
+                QSettings::SettingsMap::const_iterator v = map.constFind(key);
+                if (v != map.constEnd()) {
+                    provider = l;
+                    value = v.value();
+                    break;
+                }
+            }
+
+            if (it == flat.end()) {
+                if (provider == -1)
+                    continue;
+                FlatEntry entry;
+                entry.value = value;
+                entry.layer = provider;
+                flat.insert(key, entry);
+                if (changes)
+                    changes->added.append(key);
+            } else if (provider == -1) {
+                flat.erase(it);
+                if (changes)
+                    changes->removed.append(key);
+            } else {
+                const bool valueChanged = (it.value().value != value);
+                it.value().value = value;
+                it.value().layer = provider;
+                if (valueChanged && changes)
+                    changes->changed.append(key);
+            }
+        }
+    }
+
+    if (changes) {
+        std::sort(changes->added.begin(), changes->added.end());
+        std::sort(changes->removed.begin(), changes->removed.end());
+        std::sort(changes->changed.begin(), changes->changed.end());
+    }
+}
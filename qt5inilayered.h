@@ -0,0 +1,60 @@
+#ifndef QT5INILAYERED_H
+#define QT5INILAYERED_H
+
+#include "Qt5IniFormat_global.h"
+#include "qt5inireloader.h"
+#include "qt5inisnapshot.h"
+#include <QSettings>
+#include <QVector>
+
+/*
+    A stack of INI files (for example vendor defaults, site and user
+    settings) resolved into one flattened view. Layers added later take
+    precedence over earlier ones. Lookups go to the flattened view only,
+    so they cost one search regardless of the number of layers.
+*/
+class QT5INIFORMAT_EXPORT Qt5IniLayeredConfig
+{
+public:
+    Qt5IniLayeredConfig();
+
+    int addLayer(const QString &fileName);
+    int layerCount() const { return layers.size(); }
+    QString layerFileName(int layer) const { return layers.at(layer).fileName; }
+    const QSettings::SettingsMap &layerMap(int layer) const { return layers.at(layer).reader.settingsMap(); }
+
+    bool load();
+    bool reloadLayer(int layer, Qt5IniChangeSet *changes = nullptr);
+    bool reloadLayer(int layer, const QByteArray &data, Qt5IniChangeSet *changes = nullptr);
+
+    bool contains(const QString &key) const;
+    QVariant value(const QString &key, const QVariant &defaultValue = QVariant()) const;
+    int layerOf(const QString &key) const;
+
+    int size() const { return flat.size(); }
+    QStringList allKeys() const { return flat.keys(); }
+    QSettings::SettingsMap toSettingsMap() const;
+    Qt5IniSnapshot snapshot() const;
+
+private:
+    struct Layer
+    {
+        QString fileName;
+        Qt5IniIncrementalReloader reader;
+    };
+
+    struct FlatEntry
+    {
+        QVariant value;
+        int layer;
+    };
+    typedef QMap<QString, FlatEntry> FlatMap;
+
+    void rebuild();
+    void applyLayerChanges(int layer, const Qt5IniChangeSet &layerChanges, Qt5IniChangeSet *changes);
+
+    QVector<Layer> layers;
+    FlatMap flat;
+};
+
+#endif // QT5INILAYERED_H
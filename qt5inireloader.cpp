@@ -0,0 +1,178 @@
+#include "qt5inireloader.h"
+#include "qt5iniimpl.h"
+#include <algorithm>
+
+/*
+    Sorted merge of two key maps of the same section, collecting every key
+    that was added, removed or changed its value.
+*/
+static void collectChangedKeys(const QSettings::SettingsMap &oldKeys,
+                               const QSettings::SettingsMap &newKeys,
+                               QStringList &changedKeys)
+{
+    QSettings::SettingsMap::const_iterator i = oldKeys.constBegin();
+    QSettings::SettingsMap::const_iterator j = newKeys.constBegin();
+
+    while (i != oldKeys.constEnd() || j != newKeys.constEnd()) {
+        if (j == newKeys.constEnd() || (i != oldKeys.constEnd() && i.key() < j.key())) {
+            changedKeys.append(i.key());
+            ++i;
+        } else if (i == oldKeys.constEnd() || j.key() < i.key()) {
+            changedKeys.append(j.key());
+            ++j;
+        } else {
+            if (i.value() != j.value())
+                changedKeys.append(i.key());
+            ++i;
+            ++j;
+        }
+    }
+}
+
+static void collectAllKeys(const QSettings::SettingsMap &keys, QStringList &changedKeys)
+{
+    QSettings::SettingsMap::const_iterator i = keys.constBegin();
+    for (; i != keys.constEnd(); ++i)
+        changedKeys.append(i.key());
+}
+
+Qt5IniIncrementalReloader::Qt5IniIncrementalReloader()
+    : parsedSectionCount(0)
+{
+}
+
+bool Qt5IniIncrementalReloader::reload(QIODevice &device, Qt5IniChangeSet *changes)
+{
+    return reload(device.readAll(), changes);
+}
+
+bool Qt5IniIncrementalReloader::reload(const QByteArray &data, Qt5IniChangeSet *changes)
+{
+    if (changes)
+        changes->clear();
+
+    Qt5IniImpl::SectionMap rawSections;
+    if (!Qt5IniImpl::ReadSections(data, rawSections))
+        return false;
+
+    /*
+        Both section tables are sorted by name, so a single merge tells which
+        sections are new, gone or possibly modified. Nothing is committed
+        until every changed section parsed successfully.
+    */
+    SectionTable newSections;
+    QStringList changedKeys;
+    int parsed = 0;
+
+    Qt5IniImpl::SectionMap::const_iterator raw = rawSections.constBegin();
+    SectionTable::const_iterator old = sections.constBegin();
+    while (raw != rawSections.constEnd() || old != sections.constEnd()) {
+        if (raw == rawSections.constEnd() || (old != sections.constEnd() && old.key() < raw.key())) {
+            collectAllKeys(old.value().keys, changedKeys);
+            ++old;
+            continue;
+        }
+
+        const bool hasOld = (old != sections.constEnd() && old.key() == raw.key());
+
+        /*
+            The previous bytes of every section are kept (implicitly shared
+            with the split result), so an unchanged section is recognized by
+            comparing them, which no hash collision can fool.
+        */
+        Section section;
+        section.raw = raw.value();
+
+        if (hasOld && old.value().raw == section.raw) {
+            section.keys = old.value().keys;
+        } else {
+            if (!Qt5IniImpl::ReadSection(raw.key(), raw.value(), section.keys))
+                return false;
+            ++parsed;
+            if (hasOld)
+                collectChangedKeys(old.value().keys, section.keys, changedKeys);
+            else
+                collectAllKeys(section.keys, changedKeys);
+        }
+
+        newSections.insert(newSections.constEnd(), raw.key(), section);
+        ++raw;
+        if (hasOld)
+            ++old;
+    }
+
+    sections.swap(newSections);
+    parsedSectionCount = parsed;
+
+    /*
+        The same key can come from more than one section (a "a/b" key in
+        [General] and a "b" key in [a]), so the effective value of every
+        candidate is looked up again instead of being taken from the diff.
+    */
+    std::sort(changedKeys.begin(), changedKeys.end());
+    changedKeys.erase(std::unique(changedKeys.begin(), changedKeys.end()), changedKeys.end());
+
+    for (int k = 0; k < changedKeys.size(); ++k) {
+        const QString &key = changedKeys.at(k);
+        bool found;
+        QVariant value = resolve(key, &found);
+        QSettings::SettingsMap::iterator it = map.find(key);
+
+        if (it == map.end()) {
+            if (!found)
+                continue;
+            map.insert(key, value);
+            if (changes)
+                changes->added.append(key);
+        } else if (!found) {
+            map.erase(it);
+            if (changes)
+                changes->removed.append(key);
+        } else if (it.value() != value) {
+            it.value() = value;
+            if (changes)
+                changes->changed.append(key);
+        }
+    }
+    return true;
+}
+
+void Qt5IniIncrementalReloader::clear()
+{
+    sections.clear();
+    map.clear();
+    parsedSectionCount = 0;
+}
+
+QVariant Qt5IniIncrementalReloader::resolve(const QString &key, bool *found) const
+{
+    // longer section names sort after their prefixes and therefore win in ReadFunc
+    int from = key.size() - 1;
+    while (from >= 0) {
+        int slashPos = key.lastIndexOf(QLatin1Char('/'), from);
+        if (slashPos == -1)
+            break;
+
+        SectionTable::const_iterator it = sections.constFind(key.left(slashPos + 1));
+        if (it != sections.constEnd()) {
+            QSettings::SettingsMap::const_iterator v = it.value().keys.constFind(key);
+            if (v != it.value().keys.constEnd()) {
+                *found = true;
+                return v.value();
+            }
+        }
+        from = slashPos - 1;
+    }
+
+    SectionTable::const_iterator it = sections.constFind(QString());
+    if (it != sections.constEnd()) {
+        QSettings::SettingsMap::const_iterator v = it.value().keys.constFind(key);
+        if (v != it.value().keys.constEnd()) {
+            *found = true;
+            return v.value();
+        }
+    }
+
+    *found = false;
+    return QVariant();
+}
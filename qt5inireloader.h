@@ -0,0 +1,58 @@
+#ifndef QT5INIRELOADER_H
+#define QT5INIRELOADER_H
+
+#include "Qt5IniFormat_global.h"
+#include <QSettings>
+#include <QIODevice>
+#include <QStringList>
+
+/*
+    Keys whose effective value differs between two reloads, each list sorted.
+*/
+struct Qt5IniChangeSet
+{
+    QStringList added;
+    QStringList removed;
+    QStringList changed;
+
+    inline bool isEmpty() const
+    { return added.isEmpty() && removed.isEmpty() && changed.isEmpty(); }
+    inline void clear()
+    { added.clear(); removed.clear(); changed.clear(); }
+};
+
+/*
+    Keeps the parsed contents of one INI file together with the raw bytes
+    of every section. A reload splits the new data into sections, compares
+    them with the previous bytes and only parses the sections that changed;
+    the resulting map is identical to what Qt5IniFormatReadFunc would
+    return.
+*/
+class QT5INIFORMAT_EXPORT Qt5IniIncrementalReloader
+{
+public:
+    Qt5IniIncrementalReloader();
+
+    bool reload(QIODevice &device, Qt5IniChangeSet *changes = nullptr);
+    bool reload(const QByteArray &data, Qt5IniChangeSet *changes = nullptr);
+    void clear();
+
+    const QSettings::SettingsMap &settingsMap() const { return map; }
+    int lastParsedSectionCount() const { return parsedSectionCount; }
+
+private:
+    struct Section
+    {
+        QByteArray raw;
+        QSettings::SettingsMap keys;
+    };
+    typedef QMap<QString, Section> SectionTable;
+
+    QVariant resolve(const QString &key, bool *found) const;
+
+    SectionTable sections;
+    QSettings::SettingsMap map;
+    int parsedSectionCount;
+};
+
+#endif // QT5INIRELOADER_H
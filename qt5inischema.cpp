@@ -0,0 +1,403 @@
+#include "qt5inischema.h"
+#include "qt5iniimpl.h"
+#include <limits>
+
+struct Qt5IniRawReader::Private
+{
+    Qt5IniImpl::SectionMap sections;
+    Qt5IniImpl::SectionMap::const_iterator section;
+    bool started;
+    bool ok;
+
+    QByteArray sectionKey;
+    bool sectionIsLatin1;
+    int dataPos;
+
+    QByteArray key;
+    bool keyIsLatin1;
+    int keyStart;
+    int keyEnd;
+    int valueStart;
+    int valueEnd;
+};
+
+/*
+    The Latin-1 counterpart of iniUnescapedKey: appends the unescaped key
+    as bytes and returns false if it holds a %UXXXX character above 0xFF.
+*/
+static bool appendLatin1Key(const char *data, int from, int to, QByteArray &out)
+{
+    bool latin1 = true;
+    int i = from;
+    while (i < to) {
+        const char ch = data[i];
+
+        if (ch == '\\') {
+            out += '/';
+            ++i;
+            continue;
+        }
+
+        if (ch != '%' || i == to - 1) {
+            out += ch;
+            ++i;
+            continue;
+        }
+
+        int numDigits = 2;
+        int firstDigitPos = i + 1;
+        if (data[i + 1] == 'U') {
+            ++firstDigitPos;
+            numDigits = 4;
+        }
+
+        bool ok = false;
+        ushort value = 0;
+        if (firstDigitPos + numDigits <= to)
+            value = ushort(Qt5IniImpl::KeyEscapeValue(data + firstDigitPos, numDigits, &ok));
+        if (!ok) {
+            out += '%';
+            ++i;
+            continue;
+        }
+
+        if (value > 0xFF)
+            latin1 = false;
+        else
+            out += char(value);
+        i = firstDigitPos + numDigits;
+    }
+    return latin1;
+}
+
+Qt5IniRawReader::Qt5IniRawReader(const QByteArray &data)
+    : d(new Private)
+{
+    d->ok = Qt5IniImpl::ReadSections(data, d->sections);
+    d->started = false;
+    d->sectionIsLatin1 = true;
+    d->dataPos = 0;
+    d->keyIsLatin1 = true;
+    d->keyStart = d->keyEnd = d->valueStart = d->valueEnd = 0;
+    // keeps resize(0) from releasing the buffer between keys
+    d->key.reserve(256);
+}
+
+Qt5IniRawReader::~Qt5IniRawReader()
+{
+}
+
+bool Qt5IniRawReader::next()
+{
+    if (!d->started) {
+        d->started = true;
+        d->section = d->sections.constBegin();
+    } else if (d->section == d->sections.constEnd()) {
+        return false;
+    }
+
+    while (d->section != d->sections.constEnd()) {
+        if (d->dataPos == 0) {
+            const QString &name = d->section.key();
+            d->sectionIsLatin1 = true;
+            for (int i = 0; i < name.size() && d->sectionIsLatin1; ++i)
+                d->sectionIsLatin1 = name.at(i).unicode() <= 0xFF;
+            d->sectionKey = d->sectionIsLatin1 ? name.toLatin1() : QByteArray();
+        }
+
+        const QByteArray &data = d->section.value();
+        int lineStart;
+        int lineLen;
+        int equalsPos;
+        while (Qt5IniImpl::ReadLine(data, d->dataPos, lineStart, lineLen, equalsPos)) {
+            if (equalsPos == -1) {
+                if (data.at(lineStart) != ';')
+                    d->ok = false;
+                continue;
+            }
+
+            int keyEnd = equalsPos;
+            char ch;
+            while (keyEnd > lineStart && ((ch = data.at(keyEnd - 1)) == ' ' || ch == '\t'))
+                --keyEnd;
+
+            d->keyStart = lineStart;
+            d->keyEnd = keyEnd;
+            d->valueStart = equalsPos + 1;
+            d->valueEnd = lineStart + lineLen;
+
+            d->key.resize(0);
+            d->key += d->sectionKey;
+            d->keyIsLatin1 = appendLatin1Key(data.constData(), lineStart, keyEnd, d->key)
+                             && d->sectionIsLatin1;
+            return true;
+        }
+
+        ++d->section;
+        d->dataPos = 0;
+    }
+    return false;
+}
+
+bool Qt5IniRawReader::ok() const
+{
+    return d->ok;
+}
+
+bool Qt5IniRawReader::keyIsLatin1() const
+{
+    return d->keyIsLatin1;
+}
+
+const char *Qt5IniRawReader::key() const
+{
+    return d->key.constData();
+}
+
+int Qt5IniRawReader::keyLength() const
+{
+    return d->key.size();
+}
+
+QString Qt5IniRawReader::keyString() const
+{
+    if (d->keyIsLatin1)
+        return QString::fromLatin1(d->key.constData(), d->key.size());
+
+    QString result = d->section.key();
+    Qt5IniImpl::UnescapeKey(d->section.value(), d->keyStart, d->keyEnd, result);
+    return result;
+}
+
+const char *Qt5IniRawReader::value() const
+{
+    return d->section.value().constData() + d->valueStart;
+}
+
+int Qt5IniRawReader::valueLength() const
+{
+    return d->valueEnd - d->valueStart;
+}
+
+QVariant Qt5IniRawReader::decodedValue() const
+{
+    return Qt5IniImpl::DecodeValue(d->section.value(), d->valueStart, d->valueEnd);
+}
+
+namespace Qt5IniSchemaDetail {
+
+/*
+    A value without escapes, quotes, commas or a leading '@' decodes to its
+    own bytes minus surrounding blanks, so it can be converted in place.
+*/
+static bool plainValue(const char *data, int size, int &start, int &end)
+{
+    start = 0;
+    while (start < size && (data[start] == ' ' || data[start] == '\t'))
+        ++start;
+    end = size;
+    while (end > start && (data[end - 1] == ' ' || data[end - 1] == '\t'))
+        --end;
+
+    if (start < end && data[start] == '@')
+        return false;
+    for (int i = start; i < end; ++i) {
+        const char ch = data[i];
+        if (ch == '\\' || ch == '"' || ch == ',')
+            return false;
+    }
+    return true;
+}
+
+static bool parseUnsigned(const char *data, int start, int end, quint64 &out)
+{
+    if (start == end)
+        return false;
+
+    quint64 value = 0;
+    for (int i = start; i < end; ++i) {
+        const uint digit = uint(data[i] - '0');
+        if (digit > 9)
+            return false;
+        if (value > (std::numeric_limits<quint64>::max() - digit) / 10)
+            return false;
+        value = value * 10 + digit;
+    }
+    out = value;
+    return true;
+}
+
+static bool parseSigned(const char *data, int start, int end, qint64 &out)
+{
+    bool negative = false;
+    if (start < end && (data[start] == '-' || data[start] == '+'))
+        negative = (data[start++] == '-');
+
+    quint64 magnitude;
+    if (!parseUnsigned(data, start, end, magnitude))
+        return false;
+
+    if (negative) {
+        if (magnitude > quint64(std::numeric_limits<qint64>::max()) + 1)
+            return false;
+        out = qint64(0 - magnitude);
+    } else {
+        if (magnitude > quint64(std::numeric_limits<qint64>::max()))
+            return false;
+        out = qint64(magnitude);
+    }
+    return true;
+}
+
+QVariant decodeVariant(const char *data, int size)
+{
+    return Qt5IniImpl::DecodeValue(QByteArray::fromRawData(data, size), 0, size);
+}
+
+bool decodeValue(const char *data, int size, qint64 &out)
+{
+    int start, end;
+    if (plainValue(data, size, start, end))
+        return parseSigned(data, start, end, out);
+
+    bool ok;
+    const qint64 value = decodeVariant(data, size).toLongLong(&ok);
+    if (ok)
+        out = value;
+    return ok;
+}
+
+bool decodeValue(const char *data, int size, quint64 &out)
+{
+    int start, end;
+    if (plainValue(data, size, start, end)) {
+        if (start < end && data[start] == '+')
+            ++start;
+        return parseUnsigned(data, start, end, out);
+    }
+
+    bool ok;
+    const quint64 value = decodeVariant(data, size).toULongLong(&ok);
+    if (ok)
+        out = value;
+    return ok;
+}
+
+bool decodeValue(const char *data, int size, int &out)
+{
+    qint64 value;
+    if (!decodeValue(data, size, value)
+        || value < std::numeric_limits<int>::min() || value > std::numeric_limits<int>::max()) {
+        return false;
+    }
+    out = int(value);
+    return true;
+}
+
+bool decodeValue(const char *data, int size, uint &out)
+{
+    quint64 value;
+    if (!decodeValue(data, size, value) || value > std::numeric_limits<uint>::max())
+        return false;
+    out = uint(value);
+    return true;
+}
+
+bool decodeValue(const char *data, int size, double &out)
+{
+    int start, end;
+    bool ok;
+    double value;
+    if (plainValue(data, size, start, end))
+        value = QByteArray::fromRawData(data + start, end - start).toDouble(&ok);
+    else
+        value = decodeVariant(data, size).toDouble(&ok);
+    if (ok)
+        out = value;
+    return ok;
+}
+
+bool decodeValue(const char *data, int size, bool &out)
+{
+    int start, end;
+    if (!plainValue(data, size, start, end)) {
+        out = decodeVariant(data, size).toBool();
+        return true;
+    }
+
+    // the same rule as QVariant's QString to bool conversion
+    const int length = end - start;
+    out = !(length == 0
+            || (length == 1 && data[start] == '0')
+            || (length == 5 && qstrnicmp(data + start, "false", 5) == 0));
+    return true;
+}
+
+bool decodeValue(const char *data, int size, QString &out)
+{
+    int start, end;
+    if (plainValue(data, size, start, end)) {
+        out = QString::fromLatin1(data + start, end - start);
+        return true;
+    }
+
+    const QByteArray raw = QByteArray::fromRawData(data, size);
+    QString stringValue;
+    QStringList listValue;
+    if (!Qt5IniImpl::UnescapeValue(raw, 0, size, stringValue, listValue)
+        && !stringValue.startsWith(QLatin1Char('@'))) {
+        out = stringValue;
+        return true;
+    }
+
+    const QVariant variant = decodeVariant(data, size);
+    if (!variant.canConvert<QString>())
+        return false;
+    out = variant.toString();
+    return true;
+}
+
+bool decodeValue(const char *data, int size, QStringList &out)
+{
+    int start, end;
+    if (plainValue(data, size, start, end)) {
+        out = QStringList(QString::fromLatin1(data + start, end - start));
+        return true;
+    }
+
+    const QByteArray raw = QByteArray::fromRawData(data, size);
+    QString stringValue;
+    QStringList listValue;
+    const bool isList = Qt5IniImpl::UnescapeValue(raw, 0, size, stringValue, listValue);
+    bool typed = isList ? false : stringValue.startsWith(QLatin1Char('@'));
+    for (int i = 0; i < listValue.size() && !typed; ++i)
+        typed = listValue.at(i).startsWith(QLatin1Char('@'));
+
+    if (!typed) {
+        out = isList ? listValue : QStringList(stringValue);
+        return true;
+    }
+
+    const QVariant variant = decodeVariant(data, size);
+    if (!variant.canConvert<QStringList>())
+        return false;
+    out = variant.toStringList();
+    return true;
+}
+
+bool decodeValue(const char *data, int size, QByteArray &out)
+{
+    int start, end;
+    if (plainValue(data, size, start, end)) {
+        out = QString::fromLatin1(data + start, end - start).toUtf8();
+        return true;
+    }
+
+    const QVariant variant = decodeVariant(data, size);
+    if (!variant.canConvert<QByteArray>())
+        return false;
+    out = variant.toByteArray();
+    return true;
+}
+
+} // namespace Qt5IniSchemaDetail
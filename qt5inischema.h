@@ -0,0 +1,316 @@
+#ifndef QT5INISCHEMA_H
+#define QT5INISCHEMA_H
+
+#include "Qt5IniFormat_global.h"
+#include <QSettings>
+#include <QIODevice>
+#include <QStringList>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <utility>
+
+/*
+    Typed, compile-time INI schemas.
+
+    A schema maps fixed keys to members of a plain struct. The struct's own
+    member initializers are the defaults. The keys are hashed into a
+    perfect hash table at compile time, and matching values are decoded
+    straight from the file's bytes into the members, without going through
+    QVariant or a QMap. Keys the schema does not know can be collected in an
+    overflow map.
+
+        struct ServerConfig
+        {
+            int port = 8080;
+            QString host = QStringLiteral("localhost");
+            bool verbose = false;
+        };
+
+        static constexpr auto serverSchema = qt5IniSchema<ServerConfig>(
+            qt5IniField("server/port", &ServerConfig::port),
+            qt5IniField("server/host", &ServerConfig::host),
+            qt5IniField("log/verbose", &ServerConfig::verbose));
+        static_assert(serverSchema.isValid(), "duplicate key in serverSchema");
+
+        ServerConfig config;
+        serverSchema.read(file, config);
+
+    Keys are written the way QSettings sees them ("section/key") and must be
+    Latin-1. int, uint, qint64, quint64, double, bool, QString, QStringList
+    and QByteArray members have dedicated decoders; any other member type
+    is converted through QVariant::value<T>(). A value that cannot be
+    converted leaves the member at its default. read() decodes into a copy
+    of the struct and assigns it back only when the whole file was read, so
+    the struct must be copyable. Needs C++14.
+*/
+
+/*
+    Walks all entries of an INI file in the order Qt5IniFormatReadFunc
+    applies them. Keys are returned as unescaped Latin-1 bytes whenever
+    possible, values as their raw, still escaped bytes.
+*/
+class QT5INIFORMAT_EXPORT Qt5IniRawReader
+{
+public:
+    explicit Qt5IniRawReader(const QByteArray &data);
+    ~Qt5IniRawReader();
+
+    bool next();
+    bool ok() const;
+
+    bool keyIsLatin1() const;
+    const char *key() const;
+    int keyLength() const;
+    QString keyString() const;
+
+    const char *value() const;
+    int valueLength() const;
+    QVariant decodedValue() const;
+
+private:
+    Q_DISABLE_COPY(Qt5IniRawReader)
+
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+namespace Qt5IniSchemaDetail {
+
+QT5INIFORMAT_EXPORT QVariant decodeVariant(const char *data, int size);
+QT5INIFORMAT_EXPORT bool decodeValue(const char *data, int size, int &out);
+QT5INIFORMAT_EXPORT bool decodeValue(const char *data, int size, uint &out);
+QT5INIFORMAT_EXPORT bool decodeValue(const char *data, int size, qint64 &out);
+QT5INIFORMAT_EXPORT bool decodeValue(const char *data, int size, quint64 &out);
+QT5INIFORMAT_EXPORT bool decodeValue(const char *data, int size, double &out);
+QT5INIFORMAT_EXPORT bool decodeValue(const char *data, int size, bool &out);
+QT5INIFORMAT_EXPORT bool decodeValue(const char *data, int size, QString &out);
+QT5INIFORMAT_EXPORT bool decodeValue(const char *data, int size, QStringList &out);
+QT5INIFORMAT_EXPORT bool decodeValue(const char *data, int size, QByteArray &out);
+
+template <typename T>
+inline bool decodeValue(const char *data, int size, T &out)
+{
+    const QVariant variant = decodeVariant(data, size);
+    if (!variant.canConvert<T>())
+        return false;
+    out = variant.value<T>();
+    return true;
+}
+
+constexpr quint32 hashKey(const char *key, int length)
+{
+    // FNV-1a
+    quint32 h = 2166136261u;
+    for (int i = 0; i < length; ++i) {
+        h ^= uchar(key[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+constexpr quint32 mixHash(quint32 h, quint32 seed)
+{
+    // murmur3 finalizer
+    h ^= seed * 0x9E3779B9u;
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+constexpr int keyLength(const char *key)
+{
+    int length = 0;
+    while (key[length])
+        ++length;
+    return length;
+}
+
+constexpr int hashTableSize(int count)
+{
+    int size = 1;
+    while (size < 2 * count)
+        size <<= 1;
+    return size;
+}
+
+/*
+    Hash and displace: every key goes into one of Count buckets by its plain
+    hash, then each bucket (largest first) gets the smallest displacement
+    that moves all of its keys into free slots. A lookup costs one hash of
+    the key, two mixes and one comparison.
+*/
+template <int Count>
+class PerfectHash
+{
+public:
+    enum { TableSize = hashTableSize(Count), MaxDisplacement = 4096 };
+
+    template <typename... Keys>
+    constexpr explicit PerfectHash(Keys... keyList)
+        : keys{keyList...}, lengths(), hashes(), displacement(), slots(), valid(true)
+    {
+        int bucketOf[Count] = {};
+        int bucketStart[Count + 1] = {};
+        int bucketFill[Count] = {};
+        int members[Count] = {};
+        int maxBucketSize = 0;
+
+        for (int i = 0; i < Count; ++i) {
+            lengths[i] = keyLength(keys[i]);
+            hashes[i] = hashKey(keys[i], lengths[i]);
+            bucketOf[i] = int(hashes[i] % Count);
+            ++bucketStart[bucketOf[i] + 1];
+        }
+        for (int b = 0; b < Count; ++b) {
+            if (bucketStart[b + 1] > maxBucketSize)
+                maxBucketSize = bucketStart[b + 1];
+            bucketStart[b + 1] += bucketStart[b];
+        }
+        for (int i = 0; i < Count; ++i)
+            members[bucketStart[bucketOf[i]] + bucketFill[bucketOf[i]]++] = i;
+        for (int s = 0; s < TableSize; ++s)
+            slots[s] = -1;
+
+        for (int size = maxBucketSize; size > 0 && valid; --size) {
+            for (int b = 0; b < Count && valid; ++b) {
+                const int first = bucketStart[b];
+                const int last = bucketStart[b + 1];
+                if (last - first != size)
+                    continue;
+
+                bool placed = false;
+                for (quint32 d = 1; d < MaxDisplacement && !placed; ++d) {
+                    bool fits = true;
+                    for (int m = first; m < last && fits; ++m) {
+                        const int slot = int(mixHash(hashes[members[m]], d) & (TableSize - 1));
+                        if (slots[slot] != -1)
+                            fits = false;
+                        for (int n = first; n < m && fits; ++n) {
+                            if (int(mixHash(hashes[members[n]], d) & (TableSize - 1)) == slot)
+                                fits = false;
+                        }
+                    }
+                    if (!fits)
+                        continue;
+
+                    displacement[b] = d;
+                    for (int m = first; m < last; ++m)
+                        slots[mixHash(hashes[members[m]], d) & (TableSize - 1)] = qint16(members[m]);
+                    placed = true;
+                }
+                // two keys with the same hash, which in practice means a duplicate key
+                valid = placed;
+            }
+        }
+    }
+
+    constexpr bool isValid() const { return valid; }
+
+    int indexOf(const char *key, int length) const
+    {
+        const quint32 h = hashKey(key, length);
+        const int i = slots[mixHash(h, displacement[h % Count]) & (TableSize - 1)];
+        if (i < 0 || lengths[i] != length || memcmp(keys[i], key, size_t(length)) != 0)
+            return -1;
+        return i;
+    }
+
+private:
+    const char *keys[Count];
+    int lengths[Count];
+    quint32 hashes[Count];
+    quint32 displacement[Count];
+    qint16 slots[TableSize];
+    bool valid;
+};
+
+} // namespace Qt5IniSchemaDetail
+
+template <typename Struct, typename T>
+struct Qt5IniField
+{
+    const char *key;
+    T Struct::*member;
+};
+
+template <typename Struct, typename T>
+constexpr Qt5IniField<Struct, T> qt5IniField(const char *key, T Struct::*member)
+{
+    return Qt5IniField<Struct, T>{key, member};
+}
+
+template <typename Struct, typename... Fields>
+class Qt5IniSchema
+{
+public:
+    enum { FieldCount = sizeof...(Fields) };
+    Q_STATIC_ASSERT_X(FieldCount > 0, "a schema needs at least one field");
+
+    constexpr explicit Qt5IniSchema(Fields... fieldList)
+        : fields(fieldList...), hash(fieldList.key...) {}
+
+    constexpr bool isValid() const { return hash.isValid(); }
+
+    int indexOf(const char *key, int length) const { return hash.indexOf(key, length); }
+
+    bool read(QIODevice &device, Struct &out, QSettings::SettingsMap *overflow = nullptr) const
+    {
+        return read(device.readAll(), out, overflow);
+    }
+
+    // like Qt5IniFormatReadFunc, leaves out and overflow untouched when the data is malformed
+    bool read(const QByteArray &data, Struct &out, QSettings::SettingsMap *overflow = nullptr) const
+    {
+        Struct result(out);
+        QSettings::SettingsMap extra;
+        if (overflow)
+            extra = *overflow;
+
+        Qt5IniRawReader reader(data);
+        while (reader.next()) {
+            const int field = reader.keyIsLatin1() ? hash.indexOf(reader.key(), reader.keyLength()) : -1;
+            if (field != -1)
+                assignField(field, result, reader.value(), reader.valueLength(),
+                            std::index_sequence_for<Fields...>());
+            else if (overflow)
+                extra.insert(reader.keyString(), reader.decodedValue());
+        }
+        if (!reader.ok())
+            return false;
+
+        out = std::move(result);
+        if (overflow)
+            overflow->swap(extra);
+        return true;
+    }
+
+private:
+    template <std::size_t I>
+    static bool assign(const std::tuple<Fields...> &fields, Struct &out, const char *data, int size)
+    {
+        return Qt5IniSchemaDetail::decodeValue(data, size, out.*(std::get<I>(fields).member));
+    }
+
+    template <std::size_t... Is>
+    bool assignField(int field, Struct &out, const char *data, int size, std::index_sequence<Is...>) const
+    {
+        typedef bool (*Assigner)(const std::tuple<Fields...> &, Struct &, const char *, int);
+        static const Assigner assigners[] = { &Qt5IniSchema::assign<Is>... };
+        return assigners[field](fields, out, data, size);
+    }
+
+    std::tuple<Fields...> fields;
+    Qt5IniSchemaDetail::PerfectHash<sizeof...(Fields)> hash;
+};
+
+template <typename Struct, typename... Fields>
+constexpr Qt5IniSchema<Struct, Fields...> qt5IniSchema(Fields... fields)
+{
+    return Qt5IniSchema<Struct, Fields...>(fields...);
+}
+
+#endif // QT5INISCHEMA_H
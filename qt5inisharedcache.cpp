@@ -0,0 +1,278 @@
+#include "qt5inisharedcache.h"
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QSharedMemory>
+#include <QThread>
+#include <cstring>
+
+/*
+    Segment layout: a SharedCacheHeader followed by the Qt5IniCompactMap
+    blob. The publisher writes the blob and sets state to SegmentReady while
+    holding the segment lock; after that the blob never changes and is read
+    without locking. Only state is written again, by invalidate().
+*/
+struct SharedCacheHeader
+{
+    quint32 magic;
+    quint32 version;
+    quint32 state;
+    quint32 blobSize;
+};
+
+enum SegmentState { SegmentBuilding = 0, SegmentReady = 1, SegmentInvalidated = 2 };
+
+static const quint32 SharedCacheMagic = 0x53493551; // "Q5IS"
+static const quint32 SharedCacheVersion = 1;
+
+/*
+    How long an attaching process waits for a publisher that is still
+    writing. The publisher holds the segment lock for the whole write, so a
+    segment that is still SegmentBuilding after this long, with the lock
+    free, was left behind by a publisher that died; the waiting process
+    then writes the blob itself. The key covers the file contents, so its
+    blob is byte for byte the one the publisher would have written.
+*/
+static const int ReadyWaitAttempts = 200;
+static const int ReadyWaitMsecs = 5;
+
+struct Qt5IniSharedCache::Private
+{
+    enum AttachResult
+    {
+        AttachedReady,      // attached to a finished segment
+        AttachedStale,      // attached, but nobody finished building the segment
+        AttachFailed        // no usable segment, not attached
+    };
+
+    explicit Private(const QString &fileName)
+        : fileName(fileName), source(NotLoaded) {}
+
+    AttachResult attach();
+    bool publish(const QByteArray &blob);
+    bool rebuild(const QByteArray &blob);
+    bool writeBlob(const QByteArray &blob, bool *written);
+    bool openMap();
+    void detach();
+
+    SharedCacheHeader *header()
+    { return static_cast<SharedCacheHeader *>(segment->data()); }
+
+    QString fileName;
+    QString key;
+    // shared with every map handed out, so the segment stays attached while one of them exists
+    std::shared_ptr<QSharedMemory> segment;
+    Qt5IniCompactMap map;
+    Source source;
+};
+
+bool Qt5IniSharedCache::Private::openMap()
+{
+    const SharedCacheHeader *h = header();
+    if (h->magic != SharedCacheMagic || h->version != SharedCacheVersion
+        || quint64(segment->size()) < sizeof(SharedCacheHeader) + quint64(h->blobSize)) {
+        return false;
+    }
+
+    const char *blob = static_cast<const char *>(segment->constData()) + sizeof(SharedCacheHeader);
+    bool ok;
+    map = Qt5IniCompactMap::fromSharedBlob(QByteArray::fromRawData(blob, int(h->blobSize)),
+                                           segment, &ok);
+    return ok;
+}
+
+// drops this cache's reference; maps handed out keep the segment attached until they are gone
+void Qt5IniSharedCache::Private::detach()
+{
+    map = Qt5IniCompactMap();
+    segment.reset();
+}
+
+Qt5IniSharedCache::Private::AttachResult Qt5IniSharedCache::Private::attach()
+{
+    if (!segment->attach(QSharedMemory::ReadWrite))
+        return AttachFailed;
+
+    for (int attempt = 0; attempt < ReadyWaitAttempts; ++attempt) {
+        if (!segment->lock())
+            break;
+        const quint32 state = header()->state;
+        segment->unlock();
+
+        if (state == SegmentReady) {
+            if (!openMap())
+                break;
+            source = Attached;
+            return AttachedReady;
+        }
+        if (state != SegmentBuilding)
+            break;
+        QThread::msleep(ReadyWaitMsecs);
+    }
+    if (segment->isAttached() && segment->lock()) {
+        const bool stale = header()->state == SegmentBuilding;
+        segment->unlock();
+        if (stale)
+            return AttachedStale;
+    }
+    segment->detach();
+    return AttachFailed;
+}
+
+/*
+    Writes the blob under the segment lock unless the segment is no longer
+    SegmentBuilding, which means someone else finished it first. True if
+    the segment is ready afterwards; written tells whether it was this
+    process that filled it.
+*/
+bool Qt5IniSharedCache::Private::writeBlob(const QByteArray &blob, bool *written)
+{
+    *written = false;
+    if (!segment->lock())
+        return false;
+
+    SharedCacheHeader *h = header();
+    if (h->state == SegmentBuilding
+        && quint64(segment->size()) >= sizeof(SharedCacheHeader) + quint64(blob.size())) {
+        memcpy(h + 1, blob.constData(), size_t(blob.size()));
+        h->magic = SharedCacheMagic;
+        h->version = SharedCacheVersion;
+        h->blobSize = quint32(blob.size());
+        h->state = SegmentReady;
+        *written = true;
+    }
+    const bool ready = h->state == SegmentReady;
+    segment->unlock();
+    return ready;
+}
+
+bool Qt5IniSharedCache::Private::publish(const QByteArray &blob)
+{
+    if (blob.isEmpty()
+        || !segment->create(int(sizeof(SharedCacheHeader)) + blob.size(), QSharedMemory::ReadWrite)) {
+        return false;
+    }
+
+    bool written;
+    if (!writeBlob(blob, &written) || !openMap()) {
+        segment->detach();
+        return false;
+    }
+    source = written ? Published : Attached;
+    return true;
+}
+
+// takes over a segment whose publisher died before marking it ready
+bool Qt5IniSharedCache::Private::rebuild(const QByteArray &blob)
+{
+    bool written;
+    if (blob.isEmpty() || !writeBlob(blob, &written) || !openMap()) {
+        segment->detach();
+        return false;
+    }
+    source = written ? Published : Attached;
+    return true;
+}
+
+Qt5IniSharedCache::Qt5IniSharedCache(const QString &fileName)
+    : d(new Private(fileName))
+{
+}
+
+Qt5IniSharedCache::~Qt5IniSharedCache()
+{
+    release();
+}
+
+QString Qt5IniSharedCache::fileName() const
+{
+    return d->fileName;
+}
+
+bool Qt5IniSharedCache::load()
+{
+    release();
+
+    QFile file(d->fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    const QByteArray contents = file.readAll();
+    file.close();
+
+    d->key = cacheKey(d->fileName, contents);
+    d->segment = std::make_shared<QSharedMemory>(d->key);
+    Private::AttachResult attached = d->attach();
+    if (attached == Private::AttachedReady)
+        return true;
+
+    bool ok;
+    const Qt5IniCompactMap parsed = Qt5IniCompactMap::fromData(contents, &ok);
+    if (!ok) {
+        d->detach();
+        return false;
+    }
+    const QByteArray blob = parsed.blob();
+
+    // a process that published in the meantime wins, its copy is as good as ours
+    if (attached == Private::AttachFailed) {
+        if (d->publish(blob))
+            return true;
+        attached = d->attach();
+        if (attached == Private::AttachedReady)
+            return true;
+    }
+    if (attached == Private::AttachedStale && d->rebuild(blob))
+        return true;
+
+    d->detach();
+    d->map = parsed;
+    d->source = ParsedLocally;
+    return true;
+}
+
+void Qt5IniSharedCache::release()
+{
+    d->detach();
+    d->source = NotLoaded;
+}
+
+Qt5IniCompactMap Qt5IniSharedCache::map() const
+{
+    return d->map;
+}
+
+Qt5IniSharedCache::Source Qt5IniSharedCache::source() const
+{
+    return d->source;
+}
+
+QString Qt5IniSharedCache::cacheKey() const
+{
+    return d->key;
+}
+
+void Qt5IniSharedCache::invalidate()
+{
+    if (!d->segment || !d->segment->lock())
+        return;
+    d->header()->state = SegmentInvalidated;
+    d->segment->unlock();
+}
+
+bool Qt5IniSharedCache::isInvalidated() const
+{
+    if (!d->segment || !d->segment->lock())
+        return false;
+    const bool invalidated = d->header()->state == SegmentInvalidated;
+    d->segment->unlock();
+    return invalidated;
+}
+
+QString Qt5IniSharedCache::cacheKey(const QString &fileName, const QByteArray &contents)
+{
+    const QString path = QFileInfo(fileName).canonicalFilePath();
+    if (path.isEmpty())
+        return QString();
+    const QByteArray hash = QCryptographicHash::hash(contents, QCryptographicHash::Sha1).toHex();
+    return QLatin1String("Qt5IniSharedCache:") + path + QLatin1Char(':') + QLatin1String(hash);
+}
@@ -0,0 +1,65 @@
+#ifndef QT5INISHAREDCACHE_H
+#define QT5INISHAREDCACHE_H
+
+#include "Qt5IniFormat_global.h"
+#include "qt5inicompactmap.h"
+#include <QString>
+#include <memory>
+
+/*
+    Shares the parsed contents of one INI file between all processes on a
+    host. The first process to load a given version of the file parses it
+    and publishes the Qt5IniCompactMap blob in a QSharedMemory segment whose
+    key is derived from the file's canonical path and a hash of its
+    contents; every later process attaches to that segment and reads the
+    map from it without parsing or copying. A changed file hashes to a new
+    key, so stale data is never attached by accident.
+
+    invalidate() marks the current segment as unusable for everyone attached
+    to the same key. Later loads then parse privately until the last process
+    has detached and the segment is gone; the next load publishes afresh.
+    A segment that a publisher left unfinished, because it died while
+    writing, is rebuilt in place by the next process that loads the file.
+
+    The map returned by map() reads straight from the segment and keeps it
+    attached for as long as the map or a copy of it exists, even past the
+    next load(), release() or the destruction of the cache. Its blob() is a
+    private copy.
+*/
+class QT5INIFORMAT_EXPORT Qt5IniSharedCache
+{
+public:
+    enum Source
+    {
+        NotLoaded,      // nothing loaded, or the last load failed
+        Published,      // parsed here and published for the other processes
+        Attached,       // attached to a segment another process published
+        ParsedLocally   // parsed here only: shared memory unavailable or invalidated
+    };
+
+    explicit Qt5IniSharedCache(const QString &fileName);
+    ~Qt5IniSharedCache();
+
+    QString fileName() const;
+
+    bool load();
+    void release();
+
+    Qt5IniCompactMap map() const;
+    Source source() const;
+    QString cacheKey() const;
+
+    void invalidate();
+    bool isInvalidated() const;
+
+    // the segment key for the given file contents, empty if the file does not exist
+    static QString cacheKey(const QString &fileName, const QByteArray &contents);
+
+private:
+    Q_DISABLE_COPY(Qt5IniSharedCache)
+
+    struct Private;
+    std::unique_ptr<Private> d;
+};
+
+#endif // QT5INISHAREDCACHE_H
@@ -0,0 +1,248 @@
+#include "qt5inisnapshot.h"
+#include "qt5iniimpl.h"
+
+struct Qt5IniSnapshotData
+{
+    Qt5IniSnapshotData() : cs(Qt::CaseSensitive), generation(0) {}
+
+    QSettings::SettingsMap map;
+    Qt::CaseSensitivity cs;
+    int generation;
+    // folded key -> spelling in the file, only for keys that had capitals
+    QHash<QString, QString> originalKeys;
+};
+
+static std::shared_ptr<const Qt5IniSnapshotData> sharedEmptySnapshotData()
+{
+    static const std::shared_ptr<const Qt5IniSnapshotData> empty =
+        std::make_shared<Qt5IniSnapshotData>();
+    return empty;
+}
+
+// a copy of data published as the given generation; the maps are shared, not copied
+static std::shared_ptr<const Qt5IniSnapshotData> stampedSnapshotData(
+        const std::shared_ptr<const Qt5IniSnapshotData> &data, int generation)
+{
+    if (data->generation == generation)
+        return data;
+    std::shared_ptr<Qt5IniSnapshotData> stamped = std::make_shared<Qt5IniSnapshotData>(*data);
+    stamped->generation = generation;
+    return stamped;
+}
+
+/*
+    The name of the child right below a group of groupSegments segments, cut
+    from a key in its original spelling. Folding can change a string's
+    length (U+0130 becomes two code units), so the child is found by
+    counting segments, not by the length of the folded group prefix.
+*/
+static QString childName(const QString &key, int groupSegments)
+{
+    int start = 0;
+    for (int i = 0; i < groupSegments; ++i)
+        start = key.indexOf(QLatin1Char('/'), start) + 1;
+    const int end = key.indexOf(QLatin1Char('/'), start);
+    return end == -1 ? key.mid(start) : key.mid(start, end - start);
+}
+
+Qt5IniSnapshot::Qt5IniSnapshot()
+    : d(sharedEmptySnapshotData())
+{
+}
+
+Qt5IniSnapshot::Qt5IniSnapshot(const QSettings::SettingsMap &map)
+{
+    std::shared_ptr<Qt5IniSnapshotData> data = std::make_shared<Qt5IniSnapshotData>();
+    data->map = map;
+    d = data;
+}
+
+Qt5IniSnapshot::Qt5IniSnapshot(const std::shared_ptr<const Qt5IniSnapshotData> &data)
+    : d(data ? data : sharedEmptySnapshotData())
+{
+}
+
+Qt5IniSnapshot Qt5IniSnapshot::fromDevice(QIODevice &device, bool *ok, Qt::CaseSensitivity cs)
+{
+    std::shared_ptr<Qt5IniSnapshotData> data = std::make_shared<Qt5IniSnapshotData>();
+    data->cs = cs;
+    bool readOk;
+    if (cs == Qt::CaseInsensitive)
+        readOk = Qt5IniImpl::ReadDataCaseInsensitive(device.readAll(), data->map, data->originalKeys);
+    else
+        readOk = Qt5IniImpl::ReadFunc(device, data->map);
+    if (ok)
+        *ok = readOk;
+    if (!readOk)
+        return Qt5IniSnapshot();
+    return Qt5IniSnapshot(std::shared_ptr<const Qt5IniSnapshotData>(data));
+}
+
+QString Qt5IniSnapshot::lookupKey(const QString &key) const
+{
+    return d->cs == Qt::CaseInsensitive ? Qt5IniImpl::FoldKey(key) : key;
+}
+
+QString Qt5IniSnapshot::originalKey(const QString &key) const
+{
+    if (d->originalKeys.isEmpty())
+        return key;
+    return d->originalKeys.value(key, key);
+}
+
+Qt::CaseSensitivity Qt5IniSnapshot::caseSensitivity() const
+{
+    return d->cs;
+}
+
+int Qt5IniSnapshot::generation() const
+{
+    return d->generation;
+}
+
+bool Qt5IniSnapshot::isEmpty() const
+{
+    return d->map.isEmpty();
+}
+
+int Qt5IniSnapshot::size() const
+{
+    return d->map.size();
+}
+
+bool Qt5IniSnapshot::contains(const QString &key) const
+{
+    return d->map.contains(lookupKey(key));
+}
+
+QVariant Qt5IniSnapshot::value(const QString &key, const QVariant &defaultValue) const
+{
+    QSettings::SettingsMap::const_iterator it = d->map.constFind(lookupKey(key));
+    if (it == d->map.constEnd())
+        return defaultValue;
+    return it.value();
+}
+
+QStringList Qt5IniSnapshot::allKeys() const
+{
+    if (d->originalKeys.isEmpty())
+        return d->map.keys();
+
+    QStringList result;
+    result.reserve(d->map.size());
+    for (QSettings::SettingsMap::const_iterator it = d->map.constBegin(); it != d->map.constEnd(); ++it)
+        result.append(originalKey(it.key()));
+    return result;
+}
+
+QStringList Qt5IniSnapshot::childKeys(const QString &group) const
+{
+    const QString prefix = lookupKey(Qt5IniImpl::GroupPrefix(group));
+    const int prefixSegments = prefix.count(QLatin1Char('/'));
+    QStringList result;
+
+    QSettings::SettingsMap::const_iterator it = d->map.lowerBound(prefix);
+    for (; it != d->map.constEnd() && it.key().startsWith(prefix); ++it) {
+        if (it.key().indexOf(QLatin1Char('/'), prefix.size()) != -1)
+            continue;
+        if (d->originalKeys.isEmpty())
+            result.append(it.key().mid(prefix.size()));
+        else
+            result.append(childName(originalKey(it.key()), prefixSegments));
+    }
+    return result;
+}
+
+QStringList Qt5IniSnapshot::childGroups(const QString &group) const
+{
+    const QString prefix = lookupKey(Qt5IniImpl::GroupPrefix(group));
+    const int prefixSegments = prefix.count(QLatin1Char('/'));
+    QStringList result;
+
+    QSettings::SettingsMap::const_iterator it = d->map.lowerBound(prefix);
+    while (it != d->map.constEnd() && it.key().startsWith(prefix)) {
+        int slashPos = it.key().indexOf(QLatin1Char('/'), prefix.size());
+        if (slashPos == -1) {
+            ++it;
+            continue;
+        }
+
+        // keys are sorted, so every key of this child group follows directly
+        const QString childPrefix = it.key().left(slashPos + 1);
+        if (d->originalKeys.isEmpty())
+            result.append(it.key().mid(prefix.size(), slashPos - prefix.size()));
+        else
+            result.append(childName(originalKey(it.key()), prefixSegments));
+        while (it != d->map.constEnd() && it.key().startsWith(childPrefix))
+            ++it;
+    }
+    return result;
+}
+
+const QSettings::SettingsMap &Qt5IniSnapshot::toSettingsMap() const
+{
+    return d->map;
+}
+
+QSettings::SettingsMap Qt5IniSnapshot::originalCaseMap() const
+{
+    if (d->originalKeys.isEmpty())
+        return d->map;
+
+    QSettings::SettingsMap result;
+    for (QSettings::SettingsMap::const_iterator it = d->map.constBegin(); it != d->map.constEnd(); ++it)
+        result.insert(originalKey(it.key()), it.value());
+    return result;
+}
+
+Qt5IniSnapshotHolder::Qt5IniSnapshotHolder()
+    : current(sharedEmptySnapshotData())
+{
+}
+
+Qt5IniSnapshotHolder::Qt5IniSnapshotHolder(const Qt5IniSnapshot &snapshot)
+    : current(stampedSnapshotData(snapshot.d, 0))
+{
+}
+
+Qt5IniSnapshot Qt5IniSnapshotHolder::snapshot() const
+{
+    return Qt5IniSnapshot(std::atomic_load(&current));
+}
+
+int Qt5IniSnapshotHolder::generation() const
+{
+    return gen.loadAcquire();
+}
+
+bool Qt5IniSnapshotHolder::refresh(Qt5IniSnapshot &cached) const
+{
+    if (cached.generation() == generation())
+        return false;
+    cached = snapshot();
+    return true;
+}
+
+void Qt5IniSnapshotHolder::publish(const Qt5IniSnapshot &snapshot)
+{
+    QMutexLocker locker(&publishMutex);
+
+    /*
+        The snapshot is stored before the counter moves on, so a reader that
+        sees the new generation() always fetches a snapshot at least that
+        new; the snapshot's own generation() says which one it got.
+    */
+    const int next = gen.loadAcquire() + 1;
+    std::atomic_store(&current, stampedSnapshotData(snapshot.d, next));
+    gen.storeRelease(next);
+}
+
+bool Qt5IniSnapshotHolder::reload(QIODevice &device, Qt::CaseSensitivity cs)
+{
+    bool ok;
+    Qt5IniSnapshot snapshot = Qt5IniSnapshot::fromDevice(device, &ok, cs);
+    if (!ok)
+        return false;
+    publish(snapshot);
+    return true;
+}
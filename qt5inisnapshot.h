@@ -0,0 +1,100 @@
+#ifndef QT5INISNAPSHOT_H
+#define QT5INISNAPSHOT_H
+
+#include "Qt5IniFormat_global.h"
+#include <QSettings>
+#include <QIODevice>
+#include <QStringList>
+#include <QAtomicInt>
+#include <QMutex>
+#include <memory>
+
+struct Qt5IniSnapshotData;
+
+/*
+    An immutable view of a parsed INI file. Copies share the same data and
+    every member function is const, so a snapshot can be read from any
+    number of threads at once without locking.
+
+    A snapshot read with Qt::CaseInsensitive folds its keys once while
+    parsing; lookups then only fold the key they are given, and only when
+    it contains capitals. toSettingsMap() holds the folded keys, while
+    allKeys(), childKeys(), childGroups() and originalCaseMap() keep the
+    spelling from the file, so writing the map back does not change it.
+*/
+class QT5INIFORMAT_EXPORT Qt5IniSnapshot
+{
+public:
+    Qt5IniSnapshot();
+    explicit Qt5IniSnapshot(const QSettings::SettingsMap &map);
+
+    static Qt5IniSnapshot fromDevice(QIODevice &device, bool *ok = nullptr,
+                                     Qt::CaseSensitivity cs = Qt::CaseSensitive);
+
+    Qt::CaseSensitivity caseSensitivity() const;
+    // the Qt5IniSnapshotHolder generation this snapshot was published as, 0 if never
+    int generation() const;
+
+    bool isEmpty() const;
+    int size() const;
+
+    bool contains(const QString &key) const;
+    QVariant value(const QString &key, const QVariant &defaultValue = QVariant()) const;
+
+    QStringList allKeys() const;
+    QStringList childKeys(const QString &group) const;
+    QStringList childGroups(const QString &group) const;
+
+    const QSettings::SettingsMap &toSettingsMap() const;
+    QSettings::SettingsMap originalCaseMap() const;
+
+private:
+    explicit Qt5IniSnapshot(const std::shared_ptr<const Qt5IniSnapshotData> &data);
+
+    QString lookupKey(const QString &key) const;
+    QString originalKey(const QString &key) const;
+
+    std::shared_ptr<const Qt5IniSnapshotData> d;
+
+    friend class Qt5IniSnapshotHolder;
+};
+
+/*
+    Owns the current snapshot of a configuration and replaces it atomically
+    on reload. Readers that still hold the previous snapshot keep using it
+    until they drop their copy; they never see a partially built map.
+
+    snapshot() uses std::atomic_load on a std::shared_ptr, which libstdc++
+    implements with a global pool of mutexes (and which C++20 deprecates in
+    favour of std::atomic<std::shared_ptr>), so it does not belong on a hot
+    path. Reads are therefore not lock-free in themselves; only the polling
+    path is. Threads that look up values at a high rate keep their own copy
+    and call refresh(), which polls generation(), a single atomic load, and
+    calls snapshot() only when it differs from the cached snapshot's
+    generation(). Every published snapshot carries the generation it was
+    published as, so the cached pair can never mix a stale snapshot with a
+    newer number.
+*/
+class QT5INIFORMAT_EXPORT Qt5IniSnapshotHolder
+{
+public:
+    Qt5IniSnapshotHolder();
+    explicit Qt5IniSnapshotHolder(const Qt5IniSnapshot &snapshot);
+
+    Qt5IniSnapshot snapshot() const;
+    int generation() const;
+    // replaces cached, taken from this holder, if a newer one was published; true if it did
+    bool refresh(Qt5IniSnapshot &cached) const;
+
+    void publish(const Qt5IniSnapshot &snapshot);
+    bool reload(QIODevice &device, Qt::CaseSensitivity cs = Qt::CaseSensitive);
+
+private:
+    Q_DISABLE_COPY(Qt5IniSnapshotHolder)
+
+    std::shared_ptr<const Qt5IniSnapshotData> current;
+    QAtomicInt gen;
+    QMutex publishMutex;
+};
+
+#endif // QT5INISNAPSHOT_H
@@ -0,0 +1,169 @@
+#include "qt5inivalidator.h"
+#include "qt5iniimpl.h"
+#include <QAtomicInt>
+#include <QFile>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <limits>
+
+static const Qt5IniIssue::Kind issueKinds[] = {
+    Qt5IniIssue::UnterminatedSectionHeader,  // Qt5IniImpl::UnterminatedSectionHeader
+    Qt5IniIssue::MissingEquals,              // Qt5IniImpl::MissingEquals
+    Qt5IniIssue::EmptyKey,                   // Qt5IniImpl::EmptyKey
+    Qt5IniIssue::BadKeyEscape,               // Qt5IniImpl::BadKeyEscape
+    Qt5IniIssue::BadValueEscape,             // Qt5IniImpl::BadValueEscape
+    Qt5IniIssue::UnknownValueEscape,         // Qt5IniImpl::UnknownValueEscape
+    Qt5IniIssue::UnterminatedQuote           // Qt5IniImpl::UnterminatedQuote
+};
+
+static bool syntaxIssueLessThan(const Qt5IniImpl::SyntaxIssue &a, const Qt5IniImpl::SyntaxIssue &b)
+{
+    return a.offset < b.offset;
+}
+
+/*
+    Turns byte offsets into lines and columns with a single forward walk
+    over the data, up to the last issue only. "\r\n", '\n' and a lone '\r'
+    each end a line.
+*/
+static void locateIssues(const QByteArray &data, QVector<Qt5IniImpl::SyntaxIssue> &syntaxIssues,
+                         QVector<Qt5IniIssue> &issues)
+{
+    std::stable_sort(syntaxIssues.begin(), syntaxIssues.end(), syntaxIssueLessThan);
+
+    const char *raw = data.constData();
+    const int size = data.size();
+    int line = 1;
+    int lineBegin = 0;
+    int pos = 0;
+
+    issues.reserve(issues.size() + syntaxIssues.size());
+    for (const Qt5IniImpl::SyntaxIssue &syntaxIssue : syntaxIssues) {
+        for (; pos < syntaxIssue.offset; ++pos) {
+            const char ch = raw[pos];
+            if (ch == '\n' || (ch == '\r' && (pos + 1 == size || raw[pos + 1] != '\n'))) {
+                ++line;
+                lineBegin = pos + 1;
+            }
+        }
+
+        Qt5IniIssue issue;
+        issue.kind = issueKinds[syntaxIssue.kind];
+        issue.line = line;
+        issue.column = syntaxIssue.offset - lineBegin + 1;
+        issues.append(issue);
+    }
+}
+
+QString Qt5IniIssue::message() const
+{
+    switch (kind) {
+    case UnterminatedSectionHeader:
+        return QStringLiteral("section header is missing its closing ']'");
+    case MissingEquals:
+        return QStringLiteral("line is not a section, a key or a comment (missing '=')");
+    case EmptyKey:
+        return QStringLiteral("key is empty");
+    case BadKeyEscape:
+        return QStringLiteral("'%' in key is not followed by a valid escape");
+    case BadValueEscape:
+        return QStringLiteral("incomplete escape sequence in value");
+    case UnknownValueEscape:
+        return QStringLiteral("unknown escape sequence in value, the backslash is dropped");
+    case UnterminatedQuote:
+        return QStringLiteral("quoted string in value is never closed");
+    }
+    return QString();
+}
+
+bool Qt5IniValidator::validate(const QByteArray &data, QVector<Qt5IniIssue> *issues)
+{
+    if (!issues)
+        return Qt5IniImpl::CheckSyntax(data, nullptr);
+
+    QVector<Qt5IniImpl::SyntaxIssue> syntaxIssues;
+    const bool ok = Qt5IniImpl::CheckSyntax(data, &syntaxIssues);
+    if (!syntaxIssues.isEmpty())
+        locateIssues(data, syntaxIssues, *issues);
+    return ok;
+}
+
+bool Qt5IniValidator::validate(QIODevice &device, QVector<Qt5IniIssue> *issues)
+{
+    return validate(device.readAll(), issues);
+}
+
+Qt5IniValidationResult Qt5IniValidator::validateFile(const QString &fileName, bool collectIssues)
+{
+    Qt5IniValidationResult result;
+    result.fileName = fileName;
+    result.readable = false;
+    result.ok = false;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return result;
+    result.readable = true;
+
+    // scan the file in place where possible instead of copying it into memory
+    const qint64 size = file.size();
+    uchar *mapped = size > 0 && size <= std::numeric_limits<int>::max() ? file.map(0, size) : nullptr;
+    const QByteArray data = mapped
+            ? QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), int(size))
+            : file.readAll();
+
+    result.ok = validate(data, collectIssues ? &result.issues : nullptr);
+    return result;
+}
+
+/*
+    A fixed set of workers that take the next file index until all files
+    are done, so a large batch costs one task per thread rather than one
+    per file.
+*/
+class ValidationWorker : public QRunnable
+{
+public:
+    ValidationWorker(const QStringList &fileNames, Qt5IniValidationResult *results,
+                     QAtomicInt *nextIndex, bool collectIssues)
+        : fileNames(fileNames), results(results), nextIndex(nextIndex),
+          collectIssues(collectIssues) {}
+
+    void run() override
+    {
+        int i;
+        while ((i = nextIndex->fetchAndAddRelaxed(1)) < fileNames.size())
+            results[i] = Qt5IniValidator::validateFile(fileNames.at(i), collectIssues);
+    }
+
+private:
+    const QStringList &fileNames;
+    Qt5IniValidationResult *results;
+    QAtomicInt *nextIndex;
+    bool collectIssues;
+};
+
+QVector<Qt5IniValidationResult> Qt5IniValidator::validateFiles(const QStringList &fileNames,
+                                                               bool collectIssues, int maxThreads)
+{
+    QVector<Qt5IniValidationResult> results(fileNames.size());
+    if (maxThreads <= 0)
+        maxThreads = QThread::idealThreadCount();
+    const int threadCount = qMin(fileNames.size(), maxThreads);
+
+    if (threadCount <= 1) {
+        for (int i = 0; i < fileNames.size(); ++i)
+            results[i] = validateFile(fileNames.at(i), collectIssues);
+        return results;
+    }
+
+    QAtomicInt nextIndex(0);
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount);
+    for (int t = 0; t < threadCount; ++t)
+        pool.start(new ValidationWorker(fileNames, results.data(), &nextIndex, collectIssues));
+    pool.waitForDone();
+    return results;
+}
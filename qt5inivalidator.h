@@ -0,0 +1,67 @@
+#ifndef QT5INIVALIDATOR_H
+#define QT5INIVALIDATOR_H
+
+#include "Qt5IniFormat_global.h"
+#include <QIODevice>
+#include <QStringList>
+#include <QVector>
+
+/*
+    One problem found by Qt5IniValidator. Lines and columns start at 1;
+    columns count bytes. Errors are the lines that make
+    Qt5IniFormatReadFunc fail; everything else is accepted by the reader
+    but most likely a mistake.
+*/
+struct QT5INIFORMAT_EXPORT Qt5IniIssue
+{
+    enum Kind
+    {
+        UnterminatedSectionHeader,  // "[section" without a closing ']'
+        MissingEquals,              // a line that is neither a section, a key nor a comment
+        EmptyKey,                   // "=value"
+        BadKeyEscape,               // '%' not followed by XX or UXXXX hex digits
+        BadValueEscape,             // "\x" without hex digits, or a '\' ending the value
+        UnknownValueEscape,         // '\' before a character that has no escape, it is dropped
+        UnterminatedQuote           // a '"' in a value that is never closed
+    };
+
+    Kind kind;
+    int line;
+    int column;
+
+    bool isError() const { return kind == UnterminatedSectionHeader || kind == MissingEquals; }
+    QString message() const;
+};
+
+struct Qt5IniValidationResult
+{
+    QString fileName;
+    bool readable;  // false if the file could not be opened
+    bool ok;        // what Qt5IniFormatReadFunc would return
+    QVector<Qt5IniIssue> issues;
+};
+
+/*
+    Checks INI data without parsing it into a map: only the line scanner
+    and the key/value syntax rules run, no QString or QVariant is built for
+    the contents. Without an issue list the scan stops at the first error.
+*/
+class QT5INIFORMAT_EXPORT Qt5IniValidator
+{
+public:
+    static bool validate(const QByteArray &data, QVector<Qt5IniIssue> *issues = nullptr);
+    static bool validate(QIODevice &device, QVector<Qt5IniIssue> *issues = nullptr);
+
+    static Qt5IniValidationResult validateFile(const QString &fileName, bool collectIssues = true);
+
+    /*
+        Validates many files on a private thread pool of maxThreads threads
+        (QThread::idealThreadCount() if 0). Results are in the order of
+        fileNames.
+    */
+    static QVector<Qt5IniValidationResult> validateFiles(const QStringList &fileNames,
+                                                         bool collectIssues = true,
+                                                         int maxThreads = 0);
+};
+
+#endif // QT5INIVALIDATOR_H
@@ -0,0 +1,37 @@
+QT -= gui
+QT += testlib
+
+TEMPLATE = app
+CONFIG += c++14 console testcase
+CONFIG -= app_bundle
+
+# the library sources are compiled in so the tests can reach the internal entry points
+DEFINES += QT5INIFORMAT_LIBRARY
+INCLUDEPATH += $$PWD/..
+
+SOURCES += \
+    $$PWD/../qt5inibatchloader.cpp \
+    $$PWD/../qt5inicompactmap.cpp \
+    $$PWD/../qt5iniformat.cpp \
+    $$PWD/../qt5iniimpl.cpp \
+    $$PWD/../qt5iniincrementalparser.cpp \
+    $$PWD/../qt5inilayered.cpp \
+    $$PWD/../qt5inireloader.cpp \
+    $$PWD/../qt5inischema.cpp \
+    $$PWD/../qt5inisharedcache.cpp \
+    $$PWD/../qt5inisnapshot.cpp \
+    $$PWD/../qt5inivalidator.cpp
+
+HEADERS += \
+    $$PWD/../Qt5IniFormat_global.h \
+    $$PWD/../qt5inibatchloader.h \
+    $$PWD/../qt5inicompactmap.h \
+    $$PWD/../qt5iniformat.h \
+    $$PWD/../qt5iniimpl.h \
+    $$PWD/../qt5iniincrementalparser.h \
+    $$PWD/../qt5inilayered.h \
+    $$PWD/../qt5inireloader.h \
+    $$PWD/../qt5inischema.h \
+    $$PWD/../qt5inisharedcache.h \
+    $$PWD/../qt5inisnapshot.h \
+    $$PWD/../qt5inivalidator.h
@@ -0,0 +1,14 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    tst_qt5inibatchloader \
+    tst_qt5inicompactmap \
+    tst_qt5iniformat \
+    tst_qt5iniincrementalparser \
+    tst_qt5inilayered \
+    tst_qt5iniprojection \
+    tst_qt5inireloader \
+    tst_qt5inischema \
+    tst_qt5inisharedcache \
+    tst_qt5inisnapshot \
+    tst_qt5inivalidator
@@ -0,0 +1,208 @@
+#include "qt5inibatchloader.h"
+#include "qt5iniimpl.h"
+#include <QBuffer>
+#include <QTemporaryDir>
+#include <QtTest>
+
+/*
+    Tests for Qt5IniBatchLoader. Inputs are generated in memory and loaded
+    through QBuffer devices.
+*/
+
+// files that share most of their keys, as many per-host or per-user copies of one config do
+static QVector<QByteArray> generatedFiles(int files, int keysPerFile)
+{
+    QVector<QByteArray> result;
+    for (int f = 0; f < files; ++f) {
+        QByteArray data;
+        for (int i = 0; i < keysPerFile; ++i) {
+            if (i % 100 == 0)
+                data += "[section" + QByteArray::number(i / 100) + "]\n";
+            data += "key" + QByteArray::number(i) + '=' + "value " + QByteArray::number(f * i) + '\n';
+        }
+        data += "[file" + QByteArray::number(f) + "]\nown=" + QByteArray::number(f) + '\n';
+        result.append(data);
+    }
+    return result;
+}
+
+static QVector<Qt5IniLoadResult> loadAll(Qt5IniBatchLoader &loader, const QVector<QByteArray> &files)
+{
+    QList<QIODevice *> devices;
+    for (const QByteArray &data : files) {
+        QBuffer *buffer = new QBuffer;
+        buffer->setData(data);
+        buffer->open(QIODevice::ReadOnly);
+        devices.append(buffer);
+    }
+    const QVector<Qt5IniLoadResult> results = loader.load(devices);
+    qDeleteAll(devices);
+    return results;
+}
+
+class tst_Qt5IniBatchLoader : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void moreFilesThanPrefetch_data();
+    void moreFilesThanPrefetch();
+    void unreadableFiles();
+    void unreadableDevices();
+    void internedMatchesPlain();
+    void loadBenchmark_data();
+    void loadBenchmark();
+};
+
+void tst_Qt5IniBatchLoader::moreFilesThanPrefetch_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::addColumn<int>("prefetch");
+
+    QTest::newRow("one-slot") << 4 << 1;
+    QTest::newRow("fewer-slots-than-threads") << 4 << 2;
+    QTest::newRow("one-thread") << 1 << 3;
+    QTest::newRow("default") << 2 << 0;
+}
+
+// the reader has to wait for free slots many times over, and every result must still be right
+void tst_Qt5IniBatchLoader::moreFilesThanPrefetch()
+{
+    QFETCH(int, threads);
+    QFETCH(int, prefetch);
+
+    Qt5IniBatchLoader loader(threads);
+    loader.setMaxPrefetch(prefetch);
+    QCOMPARE(loader.maxPrefetch(), prefetch > 0 ? prefetch : 2 * threads);
+
+    const QVector<QByteArray> files = generatedFiles(10 * loader.maxPrefetch() + 3, 150);
+    const QVector<Qt5IniLoadResult> results = loadAll(loader, files);
+
+    QCOMPARE(results.size(), files.size());
+    for (int i = 0; i < files.size(); ++i) {
+        QSettings::SettingsMap expected;
+        QVERIFY(Qt5IniImpl::ReadData(files.at(i), expected));
+        QVERIFY(results.at(i).ok);
+        QVERIFY(results.at(i).errorString.isEmpty());
+        QCOMPARE(results.at(i).map, expected);
+    }
+}
+
+void tst_Qt5IniBatchLoader::unreadableFiles()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QVector<QByteArray> files = generatedFiles(6, 50);
+    QStringList fileNames;
+    for (int i = 0; i < files.size(); ++i) {
+        fileNames << dir.filePath(QStringLiteral("file%1.ini").arg(i));
+        QFile file(fileNames.last());
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(i == 4 ? QByteArray("k=1\nnot a key\n") : files.at(i));
+    }
+    // one missing file in the middle, one malformed one, and the rest fine
+    fileNames[2] = dir.filePath(QStringLiteral("missing.ini"));
+
+    Qt5IniBatchLoader loader(2);
+    loader.setMaxPrefetch(1);
+    const QVector<Qt5IniLoadResult> results = loader.load(fileNames);
+
+    QCOMPARE(results.size(), fileNames.size());
+    for (int i = 0; i < results.size(); ++i) {
+        const Qt5IniLoadResult &result = results.at(i);
+        QCOMPARE(result.fileName, fileNames.at(i));
+        if (i == 2 || i == 4) {
+            QVERIFY(!result.ok);
+            QVERIFY(!result.errorString.isEmpty());
+            QVERIFY(result.map.isEmpty());
+        } else {
+            QSettings::SettingsMap expected;
+            QVERIFY(Qt5IniImpl::ReadData(files.at(i), expected));
+            QVERIFY(result.ok);
+            QVERIFY2(result.errorString.isEmpty(), qPrintable(result.errorString));
+            QCOMPARE(result.map, expected);
+        }
+    }
+}
+
+void tst_Qt5IniBatchLoader::unreadableDevices()
+{
+    const QVector<QByteArray> files = generatedFiles(3, 50);
+    QBuffer first;
+    first.setData(files.at(0));
+    QBuffer closed;
+    QBuffer last;
+    last.setData(files.at(2));
+    QVERIFY(first.open(QIODevice::ReadOnly));
+    QVERIFY(last.open(QIODevice::ReadOnly));
+
+    Qt5IniBatchLoader loader(2);
+    const QVector<Qt5IniLoadResult> results =
+            loader.load(QList<QIODevice *>() << &first << nullptr << &closed << &last);
+
+    QCOMPARE(results.size(), 4);
+    QVERIFY(results.at(0).ok);
+    QVERIFY(results.at(0).errorString.isEmpty());
+    QVERIFY(!results.at(1).ok);
+    QVERIFY(!results.at(1).errorString.isEmpty());
+    QVERIFY(!results.at(2).ok);
+    QVERIFY(!results.at(2).errorString.isEmpty());
+    QVERIFY(results.at(3).ok);
+
+    QSettings::SettingsMap expected;
+    QVERIFY(Qt5IniImpl::ReadData(files.at(2), expected));
+    QCOMPARE(results.at(3).map, expected);
+}
+
+void tst_Qt5IniBatchLoader::internedMatchesPlain()
+{
+    const QVector<QByteArray> files = generatedFiles(12, 300);
+
+    Qt5IniBatchLoader plain(4);
+    QVERIFY(!plain.internKeys());
+    const QVector<Qt5IniLoadResult> expected = loadAll(plain, files);
+    QCOMPARE(plain.internedKeyCount(), 0);
+
+    Qt5IniBatchLoader interning(4);
+    interning.setInternKeys(true);
+    const QVector<Qt5IniLoadResult> results = loadAll(interning, files);
+
+    QCOMPARE(results.size(), expected.size());
+    for (int i = 0; i < results.size(); ++i) {
+        QVERIFY(results.at(i).ok);
+        QCOMPARE(results.at(i).map, expected.at(i).map);
+    }
+    // 300 shared keys plus one own key per file
+    QCOMPARE(interning.internedKeyCount(), 300 + files.size());
+
+    interning.clearInternedKeys();
+    QCOMPARE(interning.internedKeyCount(), 0);
+}
+
+void tst_Qt5IniBatchLoader::loadBenchmark_data()
+{
+    QTest::addColumn<bool>("internKeys");
+
+    QTest::newRow("plain") << false;
+    QTest::newRow("interned") << true;
+}
+
+// a batch load with and without key interning, for the cost of the interning table
+void tst_Qt5IniBatchLoader::loadBenchmark()
+{
+    QFETCH(bool, internKeys);
+
+    const QVector<QByteArray> files = generatedFiles(64, 2000);
+    Qt5IniBatchLoader loader;
+    loader.setInternKeys(internKeys);
+
+    QBENCHMARK {
+        const QVector<Qt5IniLoadResult> results = loadAll(loader, files);
+        QCOMPARE(results.size(), files.size());
+    }
+}
+
+QTEST_APPLESS_MAIN(tst_Qt5IniBatchLoader)
+
+#include "tst_qt5inibatchloader.moc"
@@ -0,0 +1,5 @@
+include(../tests.pri)
+
+TARGET = tst_qt5inibatchloader
+
+SOURCES += tst_qt5inibatchloader.cpp
@@ -0,0 +1,208 @@
+#include "qt5inicompactmap.h"
+#include "qt5iniimpl.h"
+#include <QtTest>
+
+/*
+    Tests for Qt5IniCompactMap: every lookup, the child key and group
+    listings and the lazily decoded values must agree with what
+    Qt5IniImpl::ReadData returns for the same file, also after the blob has
+    been stored and reopened.
+*/
+
+// the child keys of a group in a flat settings map, as QSettings lists them
+static QStringList referenceChildKeys(const QSettings::SettingsMap &map, const QString &group)
+{
+    const QString prefix = Qt5IniImpl::GroupPrefix(group);
+    QStringList result;
+    for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+        if (it.key().startsWith(prefix) && it.key().indexOf(QLatin1Char('/'), prefix.size()) == -1)
+            result.append(it.key().mid(prefix.size()));
+    }
+    return result;
+}
+
+static QStringList referenceChildGroups(const QSettings::SettingsMap &map, const QString &group)
+{
+    const QString prefix = Qt5IniImpl::GroupPrefix(group);
+    QStringList result;
+    for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+        if (!it.key().startsWith(prefix))
+            continue;
+        const int slashPos = it.key().indexOf(QLatin1Char('/'), prefix.size());
+        if (slashPos == -1)
+            continue;
+        const QString child = it.key().mid(prefix.size(), slashPos - prefix.size());
+        if (result.isEmpty() || result.last() != child)
+            result.append(child);
+    }
+    return result;
+}
+
+// every group that occurs in the map's keys, the top level, and some that do not occur
+static QStringList groupsToCheck(const QSettings::SettingsMap &map)
+{
+    QStringList groups;
+    groups << QString() << QStringLiteral("missing") << QStringLiteral("n") << QStringLiteral("net/");
+    for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+        for (int slashPos = it.key().indexOf(QLatin1Char('/')); slashPos != -1;
+             slashPos = it.key().indexOf(QLatin1Char('/'), slashPos + 1)) {
+            groups << it.key().left(slashPos);
+        }
+    }
+    groups.removeDuplicates();
+    return groups;
+}
+
+class tst_Qt5IniCompactMap : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void matchesReadData_data();
+    void matchesReadData();
+    void rawValues();
+    void badInput();
+};
+
+void tst_Qt5IniCompactMap::matchesReadData_data()
+{
+    QTest::addColumn<QByteArray>("data");
+
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("general-only") << QByteArray("b=2\na=1\nc=3\n");
+    QTest::newRow("groups")
+            << QByteArray("top=0\n"
+                          "net/inline=1\n"
+                          "[net]\n"
+                          "host=example.org\n"
+                          "proxy/port=8080\n"
+                          "proxy/host=p\n"
+                          "proxyless=1\n"
+                          "[network]\n"
+                          "mask=255\n"
+                          "[net/proxy/auth]\n"
+                          "user=u\n"
+                          "[netmask]\n"
+                          "bits=24\n");
+    QTest::newRow("duplicates")
+            << QByteArray("a/k=3\n"
+                          "[a]\n"
+                          "k=1\n"
+                          "[b]\n"
+                          "x=0\n"
+                          "[a]\n"
+                          "k=2\n"
+                          "j=4\n"
+                          "j=5\n");
+    QTest::newRow("values")
+            << QByteArray("[values]\n"
+                          "list=a, \"b,c\", d\n"
+                          "quoted=\"x, y\"\n"
+                          "escaped=tab\\there\\x263a\n"
+                          "bytes=@ByteArray(a\\0b)\n"
+                          "rect=@Rect(1 2 3 4)\n"
+                          "at=@@at\n"
+                          "empty=\n"
+                          "latin1=caf\xe9\n"
+                          "continued=one\\\n  two\n");
+    QTest::newRow("escaped-keys")
+            << QByteArray("[%General]\n"
+                          "k=1\n"
+                          "[%U263A]\n"
+                          "smile=1\n"
+                          "[sec%20tion]\n"
+                          "key%2Fslash=2\n"
+                          "a\\b=3\n");
+    QTest::newRow("crlf") << QByteArray("[s]\r\nk=1\r\n; comment\r\n[t]\r\nl=\"2\"\r\n");
+}
+
+void tst_Qt5IniCompactMap::matchesReadData()
+{
+    QFETCH(QByteArray, data);
+
+    QSettings::SettingsMap expected;
+    QVERIFY(Qt5IniImpl::ReadData(data, expected));
+
+    bool ok;
+    const Qt5IniCompactMap parsed = Qt5IniCompactMap::fromData(data, &ok);
+    QVERIFY(ok);
+    // a blob written out and read back, and one that shares storage it does not own
+    const Qt5IniCompactMap reopened = Qt5IniCompactMap::fromBlob(parsed.blob(), &ok);
+    QVERIFY(ok);
+    const QByteArray storage = parsed.blob();
+    const Qt5IniCompactMap shared = Qt5IniCompactMap::fromSharedBlob(
+            QByteArray::fromRawData(storage.constData(), storage.size()),
+            std::make_shared<QByteArray>(storage), &ok);
+    QVERIFY(ok);
+
+    for (const Qt5IniCompactMap &map : { parsed, reopened, shared }) {
+        QCOMPARE(map.size(), expected.size());
+        QCOMPARE(map.isEmpty(), expected.isEmpty());
+        QCOMPARE(map.allKeys(), expected.keys());
+        QCOMPARE(map.toSettingsMap(), expected);
+        QCOMPARE(map.blob(), parsed.blob());
+
+        int i = 0;
+        for (auto it = expected.constBegin(); it != expected.constEnd(); ++it, ++i) {
+            QCOMPARE(map.indexOf(it.key()), i);
+            QCOMPARE(map.lowerBound(it.key()), i);
+            QCOMPARE(map.keyAt(i), it.key());
+            QVERIFY(map.contains(it.key()));
+            QCOMPARE(map.value(it.key()), it.value());
+            QCOMPARE(map.valueAt(i), it.value());
+        }
+
+        QVERIFY(!map.contains(QStringLiteral("missing/key")));
+        QCOMPARE(map.indexOf(QStringLiteral("missing/key")), -1);
+        QCOMPARE(map.value(QStringLiteral("missing/key"), 42), QVariant(42));
+
+        for (const QString &group : groupsToCheck(expected)) {
+            QVERIFY2(map.childKeys(group) == referenceChildKeys(expected, group), qPrintable(group));
+            QVERIFY2(map.childGroups(group) == referenceChildGroups(expected, group), qPrintable(group));
+        }
+    }
+}
+
+void tst_Qt5IniCompactMap::rawValues()
+{
+    const QByteArray data = "[s]\nlist=a, \"b,c\"\nhex=\\x263a\nbytes=@ByteArray(xyz)\n";
+    const Qt5IniCompactMap map = Qt5IniCompactMap::fromData(data);
+
+    // values stay escaped in the blob until they are asked for
+    QCOMPARE(map.rawValueAt(map.indexOf(QStringLiteral("s/list"))), QByteArray("a, \"b,c\""));
+    QCOMPARE(map.rawValueAt(map.indexOf(QStringLiteral("s/hex"))), QByteArray("\\x263a"));
+    QCOMPARE(map.rawValueAt(map.indexOf(QStringLiteral("s/bytes"))), QByteArray("@ByteArray(xyz)"));
+
+    QCOMPARE(map.value(QStringLiteral("s/list")).toStringList(), QStringList() << "a" << "b,c");
+    QCOMPARE(map.value(QStringLiteral("s/hex")).toString(), QString(QChar(0x263a)));
+    QCOMPARE(map.value(QStringLiteral("s/bytes")).toByteArray(), QByteArray("xyz"));
+}
+
+void tst_Qt5IniCompactMap::badInput()
+{
+    bool ok = true;
+    QVERIFY(Qt5IniCompactMap::fromData("k=1\nnot a key\n", &ok).isEmpty());
+    QVERIFY(!ok);
+
+    const QByteArray blob = Qt5IniCompactMap::fromData("[s]\nk=1\nl=2\n").blob();
+    QVERIFY(!blob.isEmpty());
+
+    // truncated, padded and corrupted blobs are rejected as a whole
+    QVERIFY(Qt5IniCompactMap::fromBlob(blob.left(blob.size() - 1), &ok).isEmpty());
+    QVERIFY(!ok);
+    QVERIFY(Qt5IniCompactMap::fromBlob(blob + 'x', &ok).isEmpty());
+    QVERIFY(!ok);
+    QByteArray badMagic = blob;
+    badMagic[0] = char(badMagic.at(0) ^ 1);
+    QVERIFY(Qt5IniCompactMap::fromBlob(badMagic, &ok).isEmpty());
+    QVERIFY(!ok);
+    QVERIFY(Qt5IniCompactMap::fromBlob(QByteArray("short"), &ok).isEmpty());
+    QVERIFY(!ok);
+
+    Qt5IniCompactMap::fromBlob(blob, &ok);
+    QVERIFY(ok);
+}
+
+QTEST_APPLESS_MAIN(tst_Qt5IniCompactMap)
+
+#include "tst_qt5inicompactmap.moc"
@@ -0,0 +1,560 @@
+#include "qt5iniformat.h"
+#include "qt5iniimpl.h"
+#include "qt5inisnapshot.h"
+#include <QBuffer>
+#include <QRect>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimeZone>
+#include <QtTest>
+
+/*
+    Golden tests for the read and write paths. The scanners in
+    qt5iniimpl.cpp handle 16 bytes per step when reading and 8 characters
+    per step when writing, and finish with a scalar tail, so the generated
+    cases cover every length and every delimiter position across one and
+    two blocks.
+*/
+
+static const int MaxLength = 33;
+
+static QSettings::SettingsMap readIni(const QByteArray &data, bool *ok)
+{
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    QSettings::SettingsMap map;
+    *ok = Qt5IniFormatReadFunc(buffer, map);
+    return map;
+}
+
+static QByteArray writeIni(const QSettings::SettingsMap &map,
+                           Qt5IniWriteOptions options = Qt5IniDefaultWrite)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    if (!Qt5IniFormatWrite(buffer, map, options))
+        return QByteArray("write failed");
+    // the writer ends lines with "\r\n" on Windows
+    return buffer.data().replace("\r\n", "\n");
+}
+
+// n characters from 'g' to 'z', so none of them continues a hex or octal escape
+static QByteArray filler(int n)
+{
+    QByteArray result;
+    for (int i = 0; i < n; ++i)
+        result += char('g' + i % 20);
+    return result;
+}
+
+static QByteArray rowName(const char *kind, int n, int p = -1)
+{
+    QByteArray name = QByteArray(kind) + '/' + QByteArray::number(n);
+    if (p != -1)
+        name += '/' + QByteArray::number(p);
+    return name;
+}
+
+class tst_Qt5IniFormat : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void readValue_data();
+    void readValue();
+    void writeValue_data();
+    void writeValue();
+    void writeList_data();
+    void writeList();
+    void textualDateTime();
+    void textualYearRange_data();
+    void textualYearRange();
+    void textualWriteFunc();
+    void escapedKey_data();
+    void escapedKey();
+    void unescapedKey_data();
+    void unescapedKey();
+    void escapedKeyCacheEviction();
+    void parallelWriteMatchesSerial();
+    void rawSectionMatchesReadSection();
+    void caseInsensitiveChildNames();
+};
+
+void tst_Qt5IniFormat::readValue_data()
+{
+    QTest::addColumn<QByteArray>("value");
+    QTest::addColumn<QVariant>("expected");
+
+    for (int n = 0; n <= MaxLength; ++n) {
+        const QByteArray plain = filler(n);
+        QTest::newRow(rowName("plain", n)) << plain << QVariant(QString::fromLatin1(plain));
+
+        for (int p = 0; p <= n; ++p) {
+            const QByteArray head = plain.left(p);
+            const QByteArray tail = plain.mid(p);
+            const QString headText = QString::fromLatin1(head);
+            const QString tailText = QString::fromLatin1(tail);
+
+            QTest::newRow(rowName("newline-escape", n, p))
+                << head + "\\n" + tail << QVariant(headText + QLatin1Char('\n') + tailText);
+            QTest::newRow(rowName("backslash-escape", n, p))
+                << head + "\\\\" + tail << QVariant(headText + QLatin1Char('\\') + tailText);
+            QTest::newRow(rowName("hex-escape", n, p))
+                << head + "\\x263a" + tail << QVariant(headText + QChar(0x263a) + tailText);
+            QTest::newRow(rowName("quoted", n, p))
+                << head + "\"x,y\"" + tail << QVariant(headText + QLatin1String("x,y") + tailText);
+            QTest::newRow(rowName("comma", n, p))
+                << head + ',' + tail << QVariant(QStringList() << headText << tailText);
+            QTest::newRow(rowName("latin1", n, p))
+                << head + "\xe9\x80\xff" + tail
+                << QVariant(headText + QString::fromLatin1("\xe9\x80\xff") + tailText);
+        }
+    }
+}
+
+void tst_Qt5IniFormat::readValue()
+{
+    QFETCH(QByteArray, value);
+    QFETCH(QVariant, expected);
+
+    bool ok;
+    QSettings::SettingsMap map = readIni("k=" + value + '\n', &ok);
+    QVERIFY(ok);
+    QCOMPARE(map.value(QStringLiteral("k")), expected);
+
+    // the value ends the data, so the scanners run into the end of the buffer
+    map = readIni("k=" + value, &ok);
+    QVERIFY(ok);
+    QCOMPARE(map.value(QStringLiteral("k")), expected);
+}
+
+void tst_Qt5IniFormat::writeValue_data()
+{
+    QTest::addColumn<QVariant>("value");
+    QTest::addColumn<QByteArray>("expected");
+
+    // a hex escape swallows the hex digits after it, so those are escaped as well
+    QTest::newRow("hex-then-digits")
+        << QVariant(QChar(0x01) + QStringLiteral("abg")) << QByteArray("\\x1\\x61\\x62g");
+    QTest::newRow("hex-then-upper-digits")
+        << QVariant(QString::fromLatin1(filler(16)) + QChar(0x01) + QStringLiteral("Af"))
+        << filler(16) + "\\x1\\x41\\x66";
+    QTest::newRow("hex-at-block-end-then-digit")
+        << QVariant(QString::fromLatin1(filler(7)) + QChar(0x7f) + QStringLiteral("9"))
+        << filler(7) + "\\x7f\\x39";
+    QTest::newRow("hex-at-second-block-end-then-digit")
+        << QVariant(QString::fromLatin1(filler(15)) + QChar(0x7f) + QStringLiteral("9g"))
+        << filler(15) + "\\x7f\\x39g";
+    QTest::newRow("hex-then-non-digit")
+        << QVariant(QChar(0xe9) + QStringLiteral("g")) << QByteArray("\\xe9g");
+    QTest::newRow("nul-then-digit")
+        << QVariant(QChar(0) + QStringLiteral("5")) << QByteArray("@String(\\0\\x35)");
+
+    QTest::newRow("leading-space") << QVariant(QStringLiteral(" abc")) << QByteArray("\" abc\"");
+    QTest::newRow("trailing-space") << QVariant(QStringLiteral("abc ")) << QByteArray("\"abc \"");
+    QTest::newRow("only-space") << QVariant(QStringLiteral(" ")) << QByteArray("\" \"");
+    QTest::newRow("inner-space") << QVariant(QStringLiteral("a b")) << QByteArray("a b");
+    QTest::newRow("semicolon") << QVariant(QStringLiteral("a;b")) << QByteArray("\"a;b\"");
+    QTest::newRow("comma") << QVariant(QStringLiteral("a,b")) << QByteArray("\"a,b\"");
+    QTest::newRow("equals") << QVariant(QStringLiteral("a=b")) << QByteArray("\"a=b\"");
+    QTest::newRow("quote") << QVariant(QStringLiteral("a\"b")) << QByteArray("a\\\"b");
+    QTest::newRow("quote-and-comma") << QVariant(QStringLiteral("a\",b")) << QByteArray("\"a\\\",b\"");
+    QTest::newRow("at-sign") << QVariant(QStringLiteral("@foo")) << QByteArray("@@foo");
+
+    QTest::newRow("above-latin1") << QVariant(QString(QChar(0x263a))) << QByteArray("\\x263a");
+    QTest::newRow("above-latin1-then-digit")
+        << QVariant(QChar(0x263a) + QLatin1String("a")) << QByteArray("\\x263a\\x61");
+    QTest::newRow("above-latin1-in-list")
+        << QVariant(QStringList() << QStringLiteral("x") << QString(QChar(0x263a)) << QStringLiteral("y"))
+        << QByteArray("x, \\x263a, y");
+
+    // every length across two 8-character blocks, with the special character at every position
+    for (int n = 0; n <= MaxLength; ++n) {
+        const QByteArray plain = filler(n);
+        QTest::newRow(rowName("plain", n)) << QVariant(QString::fromLatin1(plain)) << plain;
+
+        for (int p = 0; p <= n; ++p) {
+            const QByteArray head = plain.left(p);
+            const QByteArray tail = plain.mid(p);
+            const QString headText = QString::fromLatin1(head);
+            const QString tailText = QString::fromLatin1(tail);
+
+            QTest::newRow(rowName("newline", n, p))
+                << QVariant(headText + QLatin1Char('\n') + tailText) << head + "\\n" + tail;
+            QTest::newRow(rowName("backslash", n, p))
+                << QVariant(headText + QLatin1Char('\\') + tailText) << head + "\\\\" + tail;
+            QTest::newRow(rowName("del", n, p))
+                << QVariant(headText + QChar(0x7f) + tailText) << head + "\\x7f" + tail;
+            QTest::newRow(rowName("latin1", n, p))
+                << QVariant(headText + QChar(0xff) + tailText) << head + "\\xff" + tail;
+            QTest::newRow(rowName("above-latin1", n, p))
+                << QVariant(headText + QChar(0x100) + tailText) << head + "\\x100" + tail;
+            QTest::newRow(rowName("comma", n, p))
+                << QVariant(headText + QLatin1Char(',') + tailText) << '"' + head + ',' + tail + '"';
+        }
+    }
+}
+
+void tst_Qt5IniFormat::writeValue()
+{
+    QFETCH(QVariant, value);
+    QFETCH(QByteArray, expected);
+
+    QSettings::SettingsMap map;
+    map.insert(QStringLiteral("k"), value);
+    const QByteArray written = writeIni(map);
+    QCOMPARE(written, QByteArray("[General]\nk=") + expected + '\n');
+
+    bool ok;
+    const QSettings::SettingsMap readBack = readIni(written, &ok);
+    QVERIFY(ok);
+    QCOMPARE(readBack.value(QStringLiteral("k")), value);
+}
+
+void tst_Qt5IniFormat::writeList_data()
+{
+    QTest::addColumn<QVariant>("value");
+    QTest::addColumn<QByteArray>("expected");
+    QTest::addColumn<QVariant>("readBack");
+
+    const QVariantList mixed = QVariantList() << 1 << QStringLiteral("@s") << QVariant()
+                                              << QByteArray("b") << QStringLiteral("x");
+    const QVariantList mixedReadBack = QVariantList() << QStringLiteral("1") << QStringLiteral("@s")
+                                                      << QVariant() << QByteArray("b")
+                                                      << QStringLiteral("x");
+
+    QTest::newRow("empty-string-list") << QVariant(QStringList()) << QByteArray("@Invalid()") << QVariant();
+    QTest::newRow("empty-variant-list") << QVariant(QVariantList()) << QByteArray("@Invalid()") << QVariant();
+    // a one-element string list cannot be told apart from a plain string
+    QTest::newRow("one-string") << QVariant(QStringList() << QStringLiteral("a"))
+                                << QByteArray("a") << QVariant(QStringLiteral("a"));
+    QTest::newRow("one-empty-string") << QVariant(QStringList() << QString())
+                                      << QByteArray("") << QVariant(QString());
+    // a one-element variant list is stored as a whole, as a QDataStream blob
+    QTest::newRow("one-variant")
+        << QVariant(QVariantList() << QStringLiteral("a"))
+        << QByteArray("@Variant(\\0\\0\\0\\t\\0\\0\\0\\x1\\0\\0\\0\\n\\0\\0\\0\\x2\\0\\x61)")
+        << QVariant(QVariantList() << QStringLiteral("a"));
+    QTest::newRow("strings") << QVariant(QStringList() << QStringLiteral("a") << QStringLiteral("b"))
+                             << QByteArray("a, b")
+                             << QVariant(QStringList() << QStringLiteral("a") << QStringLiteral("b"));
+    QTest::newRow("at-string") << QVariant(QStringList() << QStringLiteral("@x") << QStringLiteral("y"))
+                               << QByteArray("@@x, y")
+                               << QVariant(QStringList() << QStringLiteral("@x") << QStringLiteral("y"));
+    QTest::newRow("quoted-elements")
+        << QVariant(QStringList() << QStringLiteral("a,b") << QStringLiteral(" c"))
+        << QByteArray("\"a,b\", \" c\"")
+        << QVariant(QStringList() << QStringLiteral("a,b") << QStringLiteral(" c"));
+    QTest::newRow("mixed-typed") << QVariant(mixed)
+                                 << QByteArray("1, @@s, @Invalid(), @ByteArray(b), x")
+                                 << QVariant(mixedReadBack);
+    QTest::newRow("rect-first")
+        << QVariant(QVariantList() << QRect(1, 2, 3, 4) << QStringLiteral("plain"))
+        << QByteArray("@Rect(1 2 3 4), plain")
+        << QVariant(QVariantList() << QRect(1, 2, 3, 4) << QStringLiteral("plain"));
+}
+
+void tst_Qt5IniFormat::writeList()
+{
+    QFETCH(QVariant, value);
+    QFETCH(QByteArray, expected);
+    QFETCH(QVariant, readBack);
+
+    QSettings::SettingsMap map;
+    map.insert(QStringLiteral("k"), value);
+    const QByteArray written = writeIni(map);
+    QCOMPARE(written, QByteArray("[General]\nk=") + expected + '\n');
+
+    bool ok;
+    const QSettings::SettingsMap map2 = readIni(written, &ok);
+    QVERIFY(ok);
+    QCOMPARE(map2.value(QStringLiteral("k")), readBack);
+}
+
+void tst_Qt5IniFormat::textualDateTime()
+{
+    const QDate date(2024, 5, 1);
+    const QTime time(12, 30);
+
+    QSettings::SettingsMap map;
+    map.insert(QStringLiteral("k"), QDateTime(date, time, Qt::UTC));
+    QCOMPARE(writeIni(map, Qt5IniTextualTypes),
+             QByteArray("[General]\nk=@DateTime(2024-05-01T12:30:00.000Z)\n"));
+
+    const QTimeZone zone(QByteArrayLiteral("Europe/Berlin"));
+    if (!zone.isValid())
+        QSKIP("no time zone database");
+
+    // ISO 8601 only has the UTC offset, so a named zone keeps the QDataStream form
+    const QDateTime zoned(date, time, zone);
+    map.insert(QStringLiteral("k"), zoned);
+    const QByteArray written = writeIni(map, Qt5IniTextualTypes);
+    QVERIFY(written.startsWith("[General]\nk=@DateTime(\\0"));
+    QCOMPARE(written, writeIni(map));
+
+    bool ok;
+    const QDateTime readBack = readIni(written, &ok).value(QStringLiteral("k")).toDateTime();
+    QVERIFY(ok);
+    QCOMPARE(readBack, zoned);
+    QCOMPARE(readBack.timeSpec(), Qt::TimeZone);
+    QCOMPARE(readBack.timeZone(), zone);
+}
+
+void tst_Qt5IniFormat::textualYearRange_data()
+{
+    QTest::addColumn<QVariant>("value");
+    QTest::addColumn<bool>("textual");
+
+    const QTime time(1, 2, 3, 4);
+    QTest::newRow("date-1") << QVariant(QDate(1, 1, 1)) << true;
+    QTest::newRow("date-9999") << QVariant(QDate(9999, 12, 31)) << true;
+    QTest::newRow("date-10000") << QVariant(QDate(10000, 1, 1)) << false;
+    QTest::newRow("date-negative") << QVariant(QDate(-44, 3, 15)) << false;
+    QTest::newRow("datetime-1") << QVariant(QDateTime(QDate(1, 1, 1), time, Qt::UTC)) << true;
+    QTest::newRow("datetime-9999") << QVariant(QDateTime(QDate(9999, 12, 31), time, Qt::UTC)) << true;
+    QTest::newRow("datetime-10000") << QVariant(QDateTime(QDate(10000, 1, 1), time, Qt::UTC)) << false;
+    QTest::newRow("datetime-negative") << QVariant(QDateTime(QDate(-1, 1, 1), time, Qt::UTC)) << false;
+}
+
+// ISO 8601 as Qt writes it only has years 0 to 9999; other years keep the QDataStream form
+void tst_Qt5IniFormat::textualYearRange()
+{
+    QFETCH(QVariant, value);
+    QFETCH(bool, textual);
+#if QT_VERSION < QT_VERSION_CHECK(5, 8, 0)
+    if (value.type() == QVariant::DateTime)
+        textual = false;
+#endif
+
+    QSettings::SettingsMap map;
+    map.insert(QStringLiteral("k"), value);
+    const QByteArray written = writeIni(map, Qt5IniTextualTypes);
+    if (textual) {
+        QVERIFY(!written.contains("\\0"));
+        QVERIFY(written != writeIni(map));
+    } else {
+        QCOMPARE(written, writeIni(map));
+    }
+
+    bool ok;
+    const QVariant readBack = readIni(written, &ok).value(QStringLiteral("k"));
+    QVERIFY(ok);
+    QCOMPARE(readBack.type(), value.type());
+    QCOMPARE(readBack, value);
+}
+
+void tst_Qt5IniFormat::textualWriteFunc()
+{
+    const QSettings::Format format = QSettings::registerFormat(
+            QStringLiteral("tini"), Qt5IniFormatReadFunc, Qt5IniFormatTextualWriteFunc);
+    QVERIFY(format != QSettings::InvalidFormat);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(QStringLiteral("textual.tini"));
+    const QDate date(2024, 5, 1);
+    const QUrl url(QStringLiteral("https://example.com/a b"));
+    {
+        QSettings settings(fileName, format);
+        settings.setValue(QStringLiteral("date"), date);
+        settings.setValue(QStringLiteral("url"), url);
+        settings.sync();
+        QCOMPARE(settings.status(), QSettings::NoError);
+    }
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray contents = file.readAll().replace("\r\n", "\n");
+    QVERIFY(contents.contains("date=@Date(2024-05-01)\n"));
+    QVERIFY(contents.contains("url=@Url(https://example.com/a%20b)\n"));
+
+    QSettings settings(fileName, format);
+    QCOMPARE(settings.value(QStringLiteral("date")), QVariant(date));
+    QCOMPARE(settings.value(QStringLiteral("url")), QVariant(url));
+}
+
+void tst_Qt5IniFormat::escapedKey_data()
+{
+    QTest::addColumn<QString>("key");
+    QTest::addColumn<QByteArray>("written");
+
+    QTest::newRow("plain") << QStringLiteral("Az09-_.") << QByteArray("[General]\nAz09-_.=v\n");
+    QTest::newRow("space") << QStringLiteral("a b") << QByteArray("[General]\na%20b=v\n");
+    QTest::newRow("specials") << QStringLiteral("%;=\"~\\")
+                              << QByteArray("[General]\n%25%3B%3D%22%7E%5C=v\n");
+    QTest::newRow("control") << QStringLiteral("\t\n") << QByteArray("[General]\n%09%0A=v\n");
+    QTest::newRow("latin1") << QString::fromLatin1("caf\xe9\xff") << QByteArray("[General]\ncaf%E9%FF=v\n");
+    QTest::newRow("above-latin1") << QString(QChar(0x263a)) + QStringLiteral("x")
+                                  << QByteArray("[General]\n%U263Ax=v\n");
+    QTest::newRow("above-latin1-last") << QStringLiteral("x") + QChar(0x100)
+                                       << QByteArray("[General]\nx%U0100=v\n");
+    QTest::newRow("highest") << QString(QChar(0xffff)) << QByteArray("[General]\n%UFFFF=v\n");
+    QTest::newRow("slashes") << QStringLiteral("grp/sub/key") << QByteArray("[grp]\nsub\\key=v\n");
+    QTest::newRow("escaped-section") << QStringLiteral("g p/") + QChar(0xe9)
+                                     << QByteArray("[g%20p]\n%E9=v\n");
+    // a section named like [General] is marked, and reads back with a capital G
+    QTest::newRow("general-section") << QStringLiteral("General/k") << QByteArray("[%General]\nk=v\n");
+
+    // much longer than any one cache entry, with the first escape deep inside
+    const QString longKey = QString(5000, QLatin1Char('a')) + QChar(0x263a) + QString(5000, QLatin1Char('b'));
+    QTest::newRow("long")
+        << longKey << "[General]\n" + QByteArray(5000, 'a') + "%U263A" + QByteArray(5000, 'b') + "=v\n";
+}
+
+void tst_Qt5IniFormat::escapedKey()
+{
+    QFETCH(QString, key);
+    QFETCH(QByteArray, written);
+
+    QSettings::SettingsMap map;
+    map.insert(key, QStringLiteral("v"));
+
+    // the second write of an escaped key comes from the cache
+    QCOMPARE(writeIni(map), written);
+    QCOMPARE(writeIni(map), written);
+
+    bool ok;
+    QCOMPARE(readIni(written, &ok), map);
+    QVERIFY(ok);
+}
+
+void tst_Qt5IniFormat::unescapedKey_data()
+{
+    QTest::addColumn<QByteArray>("escaped");
+    QTest::addColumn<QString>("key");
+
+    QTest::newRow("plain") << QByteArray("Az09") << QStringLiteral("Az09");
+    QTest::newRow("backslash") << QByteArray("a\\b") << QStringLiteral("a/b");
+    QTest::newRow("upper-hex") << QByteArray("%E9%3B") << QString::fromLatin1("\xe9;");
+    QTest::newRow("lower-hex") << QByteArray("%e9%U263a") << QString::fromLatin1("\xe9") + QChar(0x263a);
+    QTest::newRow("not-hex") << QByteArray("%zz%Uxyzw") << QStringLiteral("%zz%Uxyzw");
+    QTest::newRow("percent-last") << QByteArray("a%") << QStringLiteral("a%");
+    QTest::newRow("too-short") << QByteArray("%4") << QStringLiteral("%4");
+    QTest::newRow("too-short-u") << QByteArray("%U26") << QStringLiteral("%U26");
+    QTest::newRow("latin1-bytes") << QByteArray("\xe9\xff") << QString::fromLatin1("\xe9\xff");
+
+    // accepted by QByteArray::toInt(), as they always were
+    QTest::newRow("sign") << QByteArray("%-1") << QString(QChar(0xffff));
+    QTest::newRow("plus") << QByteArray("%+F") << QString(QChar(0xf));
+    QTest::newRow("blank") << QByteArray("% F") << QString(QChar(0xf));
+    QTest::newRow("0x-prefix") << QByteArray("%U0x12") << QString(QChar(0x12));
+}
+
+void tst_Qt5IniFormat::unescapedKey()
+{
+    QFETCH(QByteArray, escaped);
+    QFETCH(QString, key);
+
+    QString result = QStringLiteral("prefix/");
+    Qt5IniImpl::UnescapeKey(escaped, 0, escaped.size(), result);
+    QCOMPARE(result, QStringLiteral("prefix/") + key);
+
+    // the same key in a file
+    bool ok;
+    const QSettings::SettingsMap map = readIni("[s]\n" + escaped + "=v\n", &ok);
+    QVERIFY(ok);
+    QCOMPARE(map.keys(), QStringList() << QStringLiteral("s/") + key);
+}
+
+void tst_Qt5IniFormat::escapedKeyCacheEviction()
+{
+    // more escaped keys than the per-thread cache holds, written twice
+    QSettings::SettingsMap map;
+    for (int i = 0; i < 6000; ++i)
+        map.insert(QStringLiteral("key %1 ").arg(i) + QChar(0x100 + i % 512), i);
+
+    const QByteArray first = writeIni(map);
+    QCOMPARE(writeIni(map), first);
+    QVERIFY(first.contains("key%20123%20%U017B="));
+
+    bool ok;
+    const QSettings::SettingsMap readBack = readIni(first, &ok);
+    QVERIFY(ok);
+    QCOMPARE(readBack.keys(), map.keys());
+}
+
+void tst_Qt5IniFormat::parallelWriteMatchesSerial()
+{
+    if (QThread::idealThreadCount() < 2)
+        QSKIP("Qt5IniParallelWrite falls back to the serial writer on one core");
+
+    // well above the 4096 key threshold, with sections larger and smaller than one 1024 key run
+    QSettings::SettingsMap map;
+    for (int i = 0; i < 3000; ++i)
+        map.insert(QStringLiteral("big/key%1").arg(i), QStringLiteral("value %1, with; specials").arg(i));
+    for (int i = 0; i < 1500; ++i)
+        map.insert(QStringLiteral("key%1").arg(i), i);
+    for (int s = 0; s < 40; ++s) {
+        for (int i = 0; i < 20; ++i) {
+            map.insert(QStringLiteral("section%1/list%2").arg(s).arg(i),
+                       QStringList() << QStringLiteral("a") << QString(QChar(0x263a)));
+            map.insert(QStringLiteral("section%1/bytes%2").arg(s).arg(i),
+                       QByteArray("\0\x01\xff", 3));
+        }
+    }
+
+    const QByteArray serial = writeIni(map);
+    for (int run = 0; run < 3; ++run)
+        QCOMPARE(writeIni(map, Qt5IniParallelWrite), serial);
+}
+
+void tst_Qt5IniFormat::rawSectionMatchesReadSection()
+{
+    const QByteArray data(
+        "[General]\n"
+        "plain=value\n"
+        "; a comment\n"
+        "quoted = \"a, b\" ; trailing comment\n"
+        "list=a, @@b, c\n"
+        "typed=1, @Invalid(), x\n"
+        "Esc%20Key=\\x263a\\\n"
+        "  continued\n"
+        "dup=first\n"
+        "[sec%2Fion]\n"
+        "dup=second\n"
+        "bytes=@ByteArray(\\0\\x1)\n"
+        "rect=@Rect(1 2 3 4)\n"
+        "dup=third\n");
+
+    Qt5IniImpl::SectionMap sections;
+    QVERIFY(Qt5IniImpl::ReadSections(data, sections));
+    QCOMPARE(sections.size(), 2);
+
+    for (Qt5IniImpl::SectionMap::const_iterator it = sections.constBegin(); it != sections.constEnd(); ++it) {
+        QSettings::SettingsMap parsed;
+        QVERIFY(Qt5IniImpl::ReadSection(it.key(), it.value(), parsed));
+
+        QVector<Qt5IniImpl::RawEntry> entries;
+        QVERIFY(Qt5IniImpl::ReadRawSection(it.key(), it.value(), entries));
+
+        // later entries of the same key win, as in ReadSection
+        QSettings::SettingsMap decoded;
+        for (const Qt5IniImpl::RawEntry &entry : entries)
+            decoded.insert(entry.key, Qt5IniImpl::DecodeValue(it.value(), entry.valueStart, entry.valueEnd));
+        QCOMPARE(decoded, parsed);
+    }
+}
+
+void tst_Qt5IniFormat::caseInsensitiveChildNames()
+{
+    // U+0130 folds to two code units, so the folded keys are longer than the original ones
+    QBuffer buffer;
+    buffer.setData("[%U0130Grp]\nKey=1\nSub/Inner=2\n[plain]\nlower=3\n");
+    buffer.open(QIODevice::ReadOnly);
+    bool ok;
+    const Qt5IniSnapshot snapshot = Qt5IniSnapshot::fromDevice(buffer, &ok, Qt::CaseInsensitive);
+    QVERIFY(ok);
+
+    const QString group = QChar(0x130) + QStringLiteral("Grp");
+    QCOMPARE(snapshot.childGroups(QString()), QStringList() << group << QStringLiteral("plain"));
+    QCOMPARE(snapshot.childKeys(group), QStringList() << QStringLiteral("Key"));
+    QCOMPARE(snapshot.childGroups(group), QStringList() << QStringLiteral("Sub"));
+    QCOMPARE(snapshot.childKeys(group + QStringLiteral("/SUB")), QStringList() << QStringLiteral("Inner"));
+    QCOMPARE(snapshot.value(group.toUpper() + QStringLiteral("/key")), QVariant(QStringLiteral("1")));
+    QCOMPARE(snapshot.childKeys(QStringLiteral("Plain")), QStringList() << QStringLiteral("lower"));
+}
+
+QTEST_APPLESS_MAIN(tst_Qt5IniFormat)
+
+#include "tst_qt5iniformat.moc"
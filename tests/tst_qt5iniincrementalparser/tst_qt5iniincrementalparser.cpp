@@ -0,0 +1,227 @@
+#include "qt5iniincrementalparser.h"
+#include "qt5iniimpl.h"
+#include <QSignalSpy>
+#include <QtTest>
+
+/*
+    Tests for Qt5IniIncrementalParser and Qt5IniImpl::IncrementalReader.
+    Every input is parsed in steps of every byte budget from 1 up to twice
+    its size, where a step covers the whole input, and in doubling budgets
+    from there up to StepSliceBytes. The result must always be what
+    Qt5IniImpl::ReadData returns for the same bytes.
+*/
+
+// what a time-limited step of Qt5IniIncrementalParser parses between two looks at the clock
+static const int StepSliceBytes = 16 * 1024;
+
+static const int MaxLength = 33;
+
+// n characters from 'g' to 'z', so none of them continues a hex or octal escape
+static QByteArray filler(int n)
+{
+    QByteArray result;
+    for (int i = 0; i < n; ++i)
+        result += char('g' + i % 20);
+    return result;
+}
+
+/*
+    One document for the golden values of one kind and length: a value with
+    the escape at every position, a section every five keys, comments, and
+    "\n" and "\r\n" line ends taking turns, so steps end on all of them.
+*/
+static QByteArray document(const QByteArray &escape, int n)
+{
+    const QByteArray plain = filler(n);
+    QByteArray data;
+    for (int p = 0; p <= n; ++p) {
+        const QByteArray eol = p % 2 ? "\r\n" : "\n";
+        if (p % 5 == 4)
+            data += "[s" + QByteArray::number(p / 5) + ']' + eol;
+        if (p % 3 == 2)
+            data += "; comment " + QByteArray::number(p) + eol;
+        data += 'k' + QByteArray::number(p) + '=' + plain.left(p) + escape + plain.mid(p) + eol;
+    }
+    return data;
+}
+
+static QSettings::SettingsMap readIncrementally(const QByteArray &data, int byteBudget, bool *ok)
+{
+    Qt5IniImpl::IncrementalReader reader(data);
+    int steps = 0;
+    while (!reader.step(byteBudget)) {
+        // every step makes progress, so the input is done after at most 2 * size steps
+        if (++steps > 2 * data.size() + 2) {
+            *ok = false;
+            return QSettings::SettingsMap();
+        }
+    }
+    *ok = reader.ok();
+    return reader.map();
+}
+
+class tst_Qt5IniIncrementalParser : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void readerMatchesReadData_data();
+    void readerMatchesReadData();
+    void parserMatchesReadData_data();
+    void parserMatchesReadData();
+    void largeInput();
+    void timerSteps();
+};
+
+void tst_Qt5IniIncrementalParser::readerMatchesReadData_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<bool>("expectedOk");
+
+    const char *const kinds[][2] = {
+        { "plain", "" },
+        { "newline-escape", "\\n" },
+        { "backslash-escape", "\\\\" },
+        { "hex-escape", "\\x263a" },
+        { "quoted", "\"x,y\"" },
+        { "comma", "," },
+        { "latin1", "\xe9\x80\xff" },
+        { "continued", "\\\n  " }
+    };
+    for (const auto &kind : kinds) {
+        for (int n = 0; n <= MaxLength; ++n) {
+            QTest::newRow(QByteArray(kind[0]) + '/' + QByteArray::number(n))
+                << document(kind[1], n) << true;
+        }
+    }
+
+    QTest::newRow("empty") << QByteArray() << true;
+    QTest::newRow("only-comments") << QByteArray("; a\r\n;b\n") << true;
+    QTest::newRow("no-final-eol") << QByteArray("[s]\r\nk=v") << true;
+    QTest::newRow("cr-only") << QByteArray("k=1\r[s]\rk=2\r") << true;
+
+    // malformed: ReadData fails and leaves the map empty
+    QTest::newRow("line-without-equals") << QByteArray("k=1\njunk\nl=2\n") << false;
+    QTest::newRow("unterminated-section") << QByteArray("k=1\n[open\nl=2\n") << false;
+    QTest::newRow("bad-line-after-crlf") << QByteArray("k=1\r\n[s]\r\nl=2\r\nbad\r\n") << false;
+    QTest::newRow("bad-last-line") << QByteArray("[a]\nk=1\n[b]\nl=2\nbad") << false;
+}
+
+void tst_Qt5IniIncrementalParser::readerMatchesReadData()
+{
+    QFETCH(QByteArray, data);
+    QFETCH(bool, expectedOk);
+
+    QSettings::SettingsMap expected;
+    QCOMPARE(Qt5IniImpl::ReadData(data, expected), expectedOk);
+
+    for (int budget = 1; budget <= StepSliceBytes;
+         budget = budget <= 2 * data.size() ? budget + 1 : 2 * budget) {
+        bool ok;
+        const QSettings::SettingsMap map = readIncrementally(data, budget, &ok);
+        QVERIFY2(ok == expectedOk, QByteArray("budget " + QByteArray::number(budget)).constData());
+        QVERIFY2(map == expected, QByteArray("budget " + QByteArray::number(budget)).constData());
+    }
+    bool ok;
+    QCOMPARE(readIncrementally(data, StepSliceBytes, &ok), expected);
+    QCOMPARE(ok, expectedOk);
+}
+
+void tst_Qt5IniIncrementalParser::parserMatchesReadData_data()
+{
+    readerMatchesReadData_data();
+}
+
+void tst_Qt5IniIncrementalParser::parserMatchesReadData()
+{
+    QFETCH(QByteArray, data);
+    QFETCH(bool, expectedOk);
+
+    QSettings::SettingsMap expected;
+    QCOMPARE(Qt5IniImpl::ReadData(data, expected), expectedOk);
+
+    for (int budget : { 1, 2, 3, 7, 16, 17, StepSliceBytes }) {
+        Qt5IniIncrementalParser parser;
+        QSignalSpy spy(&parser, &Qt5IniIncrementalParser::finished);
+        parser.setData(data);
+
+        int steps = 0;
+        while (!parser.stepBytes(budget))
+            QVERIFY(++steps <= 2 * data.size() + 2);
+
+        QVERIFY(parser.isFinished());
+        QCOMPARE(parser.ok(), expectedOk);
+        QCOMPARE(parser.progress(), qreal(1.0));
+        QCOMPARE(parser.map(), expected);
+
+        // more steps after the end do not deliver the result again
+        QVERIFY(parser.stepBytes(budget));
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(spy.at(0).at(0).toMap(), expected);
+        QCOMPARE(spy.at(0).at(1).toBool(), expectedOk);
+    }
+}
+
+void tst_Qt5IniIncrementalParser::largeInput()
+{
+    // several slices long, with lines crossing every slice boundary
+    QByteArray data;
+    for (int i = 0; data.size() < 5 * StepSliceBytes; ++i) {
+        if (i % 500 == 0)
+            data += "[section" + QByteArray::number(i / 500) + "]\r\n";
+        data += "key" + QByteArray::number(i) + "=\"value, " + filler(i % 40) + "\\x263a\"\r\n";
+    }
+
+    QSettings::SettingsMap expected;
+    QVERIFY(Qt5IniImpl::ReadData(data, expected));
+
+    for (int budget : { StepSliceBytes - 1, StepSliceBytes, StepSliceBytes + 1, 3 * StepSliceBytes }) {
+        bool ok;
+        QCOMPARE(readIncrementally(data, budget, &ok), expected);
+        QVERIFY(ok);
+    }
+
+    Qt5IniIncrementalParser parser;
+    parser.setData(data);
+    QCOMPARE(parser.progress(), qreal(0.0));
+    qreal progress = 0.0;
+    while (!parser.step(0)) {
+        QVERIFY(parser.progress() >= progress);
+        progress = parser.progress();
+    }
+    QVERIFY(parser.ok());
+    QCOMPARE(parser.map(), expected);
+}
+
+void tst_Qt5IniIncrementalParser::timerSteps()
+{
+    QByteArray data;
+    for (int i = 0; i < 20000; ++i)
+        data += "[s" + QByteArray::number(i / 100) + "]\nk" + QByteArray::number(i) + "=v\n";
+
+    QSettings::SettingsMap expected;
+    QVERIFY(Qt5IniImpl::ReadData(data, expected));
+
+    Qt5IniIncrementalParser parser;
+    QSignalSpy spy(&parser, &Qt5IniIncrementalParser::finished);
+    parser.setData(data);
+    parser.start(1);
+    QVERIFY(parser.isRunning());
+    QVERIFY(spy.wait(30000));
+    QVERIFY(!parser.isRunning());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toMap(), expected);
+    QVERIFY(spy.at(0).at(1).toBool());
+
+    // a malformed input is reported once, with an empty map
+    parser.setData("k=1\nbad\n");
+    parser.start(1);
+    QVERIFY(spy.wait(30000));
+    QCOMPARE(spy.count(), 2);
+    QVERIFY(spy.at(1).at(0).toMap().isEmpty());
+    QVERIFY(!spy.at(1).at(1).toBool());
+}
+
+QTEST_GUILESS_MAIN(tst_Qt5IniIncrementalParser)
+
+#include "tst_qt5iniincrementalparser.moc"
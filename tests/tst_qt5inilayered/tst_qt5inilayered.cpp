@@ -0,0 +1,215 @@
+#include "qt5inilayered.h"
+#include "qt5iniimpl.h"
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+/*
+    Tests for Qt5IniLayeredConfig: which layer provides each key, what a
+    reload of one layer changes in the flattened view, and that the
+    parallel load() gives the same view as loading layer by layer.
+*/
+
+static bool writeFile(const QString &fileName, const QByteArray &data)
+{
+    QFile file(fileName);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+// the flattened view computed the slow way: every layer's map on top of the ones below
+static QSettings::SettingsMap mergedLayers(const QVector<QByteArray> &layers, QMap<QString, int> *providers)
+{
+    QSettings::SettingsMap merged;
+    for (int l = 0; l < layers.size(); ++l) {
+        QSettings::SettingsMap map;
+        if (!Qt5IniImpl::ReadData(layers.at(l), map))
+            return QSettings::SettingsMap();
+        for (QSettings::SettingsMap::const_iterator it = map.constBegin(); it != map.constEnd(); ++it) {
+            merged.insert(it.key(), it.value());
+            providers->insert(it.key(), l);
+        }
+    }
+    return merged;
+}
+
+class tst_Qt5IniLayered : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void precedence();
+    void removedKeyFallsBack();
+    void lowerLayerChangeHidden();
+    void reloadFromFile();
+    void parallelLoadMatchesSerial();
+
+private:
+    QString layerFile(int layer) const
+    { return dir.filePath(QStringLiteral("layer%1.ini").arg(layer)); }
+
+    QTemporaryDir dir;
+    Qt5IniLayeredConfig config;
+};
+
+static const char defaults[] = "[ui]\ncolor=gray\nsize=10\nfont=sans\n[net]\nproxy=none\n";
+static const char site[] = "[ui]\ncolor=blue\n[net]\nproxy=site\ntimeout=30\n";
+static const char user[] = "[ui]\ncolor=red\nsize=12\n";
+
+void tst_Qt5IniLayered::init()
+{
+    QVERIFY(dir.isValid());
+    QVERIFY(writeFile(layerFile(0), defaults));
+    QVERIFY(writeFile(layerFile(1), site));
+    QVERIFY(writeFile(layerFile(2), user));
+
+    config = Qt5IniLayeredConfig();
+    for (int l = 0; l < 3; ++l)
+        QCOMPARE(config.addLayer(layerFile(l)), l);
+    QVERIFY(config.load());
+}
+
+void tst_Qt5IniLayered::precedence()
+{
+    QCOMPARE(config.layerCount(), 3);
+    QCOMPARE(config.value("ui/color"), QVariant("red"));
+    QCOMPARE(config.layerOf("ui/color"), 2);
+    QCOMPARE(config.value("ui/size"), QVariant("12"));
+    QCOMPARE(config.layerOf("ui/size"), 2);
+    QCOMPARE(config.value("ui/font"), QVariant("sans"));
+    QCOMPARE(config.layerOf("ui/font"), 0);
+    QCOMPARE(config.value("net/proxy"), QVariant("site"));
+    QCOMPARE(config.layerOf("net/proxy"), 1);
+    QCOMPARE(config.value("net/timeout"), QVariant("30"));
+    QCOMPARE(config.layerOf("net/timeout"), 1);
+
+    QVERIFY(!config.contains("ui/missing"));
+    QCOMPARE(config.layerOf("ui/missing"), -1);
+    QCOMPARE(config.value("ui/missing", 7), QVariant(7));
+
+    QMap<QString, int> providers;
+    const QSettings::SettingsMap expected
+        = mergedLayers(QVector<QByteArray>() << defaults << site << user, &providers);
+    QCOMPARE(config.toSettingsMap(), expected);
+    QCOMPARE(config.size(), expected.size());
+    QCOMPARE(config.allKeys(), expected.keys());
+    QCOMPARE(config.snapshot().value("ui/color"), QVariant("red"));
+}
+
+void tst_Qt5IniLayered::removedKeyFallsBack()
+{
+    Qt5IniChangeSet changes;
+
+    // ui/color goes back to the site value, ui/size to the default one
+    QVERIFY(config.reloadLayer(2, QByteArray("[ui]\nextra=1\n"), &changes));
+    QCOMPARE(changes.added, QStringList() << "ui/extra");
+    QCOMPARE(changes.removed, QStringList());
+    QCOMPARE(changes.changed, QStringList() << "ui/color" << "ui/size");
+    QCOMPARE(config.value("ui/color"), QVariant("blue"));
+    QCOMPARE(config.layerOf("ui/color"), 1);
+    QCOMPARE(config.value("ui/size"), QVariant("10"));
+    QCOMPARE(config.layerOf("ui/size"), 0);
+
+    // net/timeout is only in the site layer and goes away with it
+    QVERIFY(config.reloadLayer(1, QByteArray(), &changes));
+    QCOMPARE(changes.added, QStringList());
+    QCOMPARE(changes.removed, QStringList() << "net/timeout");
+    QCOMPARE(changes.changed, QStringList() << "net/proxy" << "ui/color");
+    QCOMPARE(config.value("ui/color"), QVariant("gray"));
+    QCOMPARE(config.layerOf("ui/color"), 0);
+    QCOMPARE(config.value("net/proxy"), QVariant("none"));
+
+    // a higher layer taking over a key with the same value changes the provider only
+    QVERIFY(config.reloadLayer(2, QByteArray("[ui]\nfont=sans\n"), &changes));
+    QCOMPARE(changes.added, QStringList());
+    QCOMPARE(changes.removed, QStringList() << "ui/extra");
+    QCOMPARE(changes.changed, QStringList());
+    QCOMPARE(config.layerOf("ui/font"), 2);
+
+    QMap<QString, int> providers;
+    const QSettings::SettingsMap expected
+        = mergedLayers(QVector<QByteArray>() << defaults << QByteArray() << "[ui]\nfont=sans\n", &providers);
+    QCOMPARE(config.toSettingsMap(), expected);
+    for (QMap<QString, int>::const_iterator it = providers.constBegin(); it != providers.constEnd(); ++it)
+        QCOMPARE(config.layerOf(it.key()), it.value());
+}
+
+void tst_Qt5IniLayered::lowerLayerChangeHidden()
+{
+    Qt5IniChangeSet changes;
+    QVERIFY(config.reloadLayer(0, QByteArray("[ui]\ncolor=black\nsize=10\nfont=serif\n[net]\nproxy=none\n"),
+                               &changes));
+    QCOMPARE(changes.added, QStringList());
+    QCOMPARE(changes.removed, QStringList());
+    QCOMPARE(changes.changed, QStringList() << "ui/font");
+    QCOMPARE(config.value("ui/color"), QVariant("red"));
+    QCOMPARE(config.layerMap(0).value("ui/color"), QVariant("black"));
+
+    // a failed reload changes nothing
+    QVERIFY(!config.reloadLayer(0, QByteArray("[ui\n"), &changes));
+    QVERIFY(changes.isEmpty());
+    QCOMPARE(config.value("ui/font"), QVariant("serif"));
+}
+
+void tst_Qt5IniLayered::reloadFromFile()
+{
+    QVERIFY(writeFile(layerFile(1), "[net]\nproxy=other\n"));
+    Qt5IniChangeSet changes;
+    QVERIFY(config.reloadLayer(1, &changes));
+    QCOMPARE(changes.removed, QStringList() << "net/timeout");
+    // ui/color left the site layer too, but the user layer still overrides it
+    QCOMPARE(changes.changed, QStringList() << "net/proxy");
+    QCOMPARE(config.value("net/proxy"), QVariant("other"));
+
+    // a missing layer file is an empty layer
+    QVERIFY(QFile::remove(layerFile(2)));
+    QVERIFY(config.reloadLayer(2, &changes));
+    QCOMPARE(changes.changed, QStringList() << "ui/color" << "ui/size");
+    QCOMPARE(config.value("ui/color"), QVariant("gray"));
+}
+
+void tst_Qt5IniLayered::parallelLoadMatchesSerial()
+{
+    // layers that override each other in every combination
+    const int layerCount = 9;
+    QVector<QByteArray> contents;
+    for (int l = 0; l < layerCount; ++l) {
+        QByteArray data;
+        for (int s = 0; s < 10; ++s) {
+            data += "[s" + QByteArray::number(s) + "]\n";
+            for (int k = 0; k < 200; ++k) {
+                if ((k + s) % (l + 2) == 0)
+                    data += 'k' + QByteArray::number(k) + "=layer" + QByteArray::number(l) + '\n';
+            }
+        }
+        contents.append(data);
+        QVERIFY(writeFile(layerFile(l), data));
+    }
+
+    Qt5IniLayeredConfig parallel;
+    Qt5IniLayeredConfig serial;
+    for (int l = 0; l < layerCount; ++l) {
+        parallel.addLayer(layerFile(l));
+        serial.addLayer(layerFile(l));
+    }
+    QVERIFY(parallel.load());
+    for (int l = 0; l < layerCount; ++l)
+        QVERIFY(serial.reloadLayer(l));
+
+    QMap<QString, int> providers;
+    const QSettings::SettingsMap expected = mergedLayers(contents, &providers);
+    QCOMPARE(parallel.toSettingsMap(), expected);
+    QCOMPARE(serial.toSettingsMap(), expected);
+    for (QMap<QString, int>::const_iterator it = providers.constBegin(); it != providers.constEnd(); ++it) {
+        QCOMPARE(parallel.layerOf(it.key()), it.value());
+        QCOMPARE(serial.layerOf(it.key()), it.value());
+    }
+
+    // loading again from the same files changes nothing
+    QVERIFY(parallel.load());
+    QCOMPARE(parallel.toSettingsMap(), expected);
+}
+
+QTEST_APPLESS_MAIN(tst_Qt5IniLayered)
+
+#include "tst_qt5inilayered.moc"
@@ -0,0 +1,175 @@
+#include "qt5iniformat.h"
+#include "qt5iniimpl.h"
+#include <QBuffer>
+#include <QtTest>
+
+/*
+    Tests for the projected reads Qt5IniFormatReadSections and
+    Qt5IniFormatReadKeyPrefixes: the result must be exactly the matching
+    subset of what Qt5IniFormatReadFunc returns for the same data.
+*/
+
+// section and key names that share leading characters without sharing a path segment
+static const QByteArray projectionData =
+    "top=0\n"
+    "net/inline=1\n"
+    "[net]\n"
+    "host=a\n"
+    "proxy/port=2\n"
+    "proxyless=3\n"
+    "[network]\n"
+    "mask=255\n"
+    "[net/proxy]\n"
+    "host=p\n"
+    "[netmask]\n"
+    "bits=24\n";
+
+typedef bool (*ProjectedReadFunc)(QIODevice &, QSettings::SettingsMap &, const QStringList &);
+
+static QSettings::SettingsMap readFull(const QByteArray &data, bool *ok)
+{
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    QSettings::SettingsMap map;
+    *ok = Qt5IniFormatReadFunc(buffer, map);
+    return map;
+}
+
+static QSettings::SettingsMap readProjected(ProjectedReadFunc func, const QByteArray &data,
+                                            const QStringList &names, bool *ok)
+{
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    QSettings::SettingsMap map;
+    *ok = func(buffer, map, names);
+    return map;
+}
+
+class tst_Qt5IniProjection : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void keyPrefixes_data();
+    void keyPrefixes();
+    void sections_data();
+    void sections();
+    void skippedSectionsAreNotChecked();
+};
+
+void tst_Qt5IniProjection::keyPrefixes_data()
+{
+    QTest::addColumn<QStringList>("prefixes");
+    QTest::addColumn<QStringList>("expectedKeys");
+
+    QTest::newRow("segment-boundary") << QStringList{ "net/" }
+            << QStringList{ "net/host", "net/inline", "net/proxy/host", "net/proxy/port",
+                            "net/proxyless" };
+    QTest::newRow("inside-segment") << QStringList{ "net" }
+            << QStringList{ "net/host", "net/inline", "net/proxy/host", "net/proxy/port",
+                            "net/proxyless", "netmask/bits", "network/mask" };
+    QTest::newRow("nested-boundary") << QStringList{ "net/proxy/" }
+            << QStringList{ "net/proxy/host", "net/proxy/port" };
+    QTest::newRow("nested-inside-segment") << QStringList{ "net/proxy" }
+            << QStringList{ "net/proxy/host", "net/proxy/port", "net/proxyless" };
+    QTest::newRow("section-name-part") << QStringList{ "netw" } << QStringList{ "network/mask" };
+    QTest::newRow("whole-key") << QStringList{ "net/host" } << QStringList{ "net/host" };
+    QTest::newRow("several") << QStringList{ "top", "netmask/" }
+            << QStringList{ "netmask/bits", "top" };
+    QTest::newRow("everything") << QStringList{ "" }
+            << QStringList{ "net/host", "net/inline", "net/proxy/host", "net/proxy/port",
+                            "net/proxyless", "netmask/bits", "network/mask", "top" };
+    QTest::newRow("nothing") << QStringList{ "missing/" } << QStringList();
+    QTest::newRow("no-prefixes") << QStringList() << QStringList();
+}
+
+void tst_Qt5IniProjection::keyPrefixes()
+{
+    QFETCH(QStringList, prefixes);
+    QFETCH(QStringList, expectedKeys);
+
+    bool ok;
+    const QSettings::SettingsMap full = readFull(projectionData, &ok);
+    QVERIFY(ok);
+
+    // the keys of the full read under any of the prefixes, with the same values
+    QSettings::SettingsMap expected;
+    for (auto it = full.constBegin(); it != full.constEnd(); ++it) {
+        for (const QString &prefix : prefixes) {
+            if (it.key().startsWith(prefix)) {
+                expected.insert(it.key(), it.value());
+                break;
+            }
+        }
+    }
+    QCOMPARE(expected.keys(), expectedKeys);
+
+    const QSettings::SettingsMap map =
+            readProjected(Qt5IniFormatReadKeyPrefixes, projectionData, prefixes, &ok);
+    QVERIFY(ok);
+    QCOMPARE(map, expected);
+}
+
+void tst_Qt5IniProjection::sections_data()
+{
+    QTest::addColumn<QStringList>("sections");
+    QTest::addColumn<QStringList>("expectedKeys");
+
+    // a section is matched by its whole name: [net] is neither [network] nor [net/proxy]
+    QTest::newRow("one") << QStringList{ "net" }
+            << QStringList{ "net/host", "net/proxy/port", "net/proxyless" };
+    QTest::newRow("general") << QStringList{ "" } << QStringList{ "net/inline", "top" };
+    QTest::newRow("nested") << QStringList{ "net/proxy" } << QStringList{ "net/proxy/host" };
+    QTest::newRow("several") << QStringList{ "network", "netmask" }
+            << QStringList{ "netmask/bits", "network/mask" };
+    QTest::newRow("name-part") << QStringList{ "ne" } << QStringList();
+    QTest::newRow("trailing-slash") << QStringList{ "net/" } << QStringList();
+    QTest::newRow("no-sections") << QStringList() << QStringList();
+}
+
+void tst_Qt5IniProjection::sections()
+{
+    QFETCH(QStringList, sections);
+    QFETCH(QStringList, expectedKeys);
+
+    bool ok;
+    const QSettings::SettingsMap full = readFull(projectionData, &ok);
+    QVERIFY(ok);
+
+    const QSettings::SettingsMap map =
+            readProjected(Qt5IniFormatReadSections, projectionData, sections, &ok);
+    QVERIFY(ok);
+    QCOMPARE(map.keys(), expectedKeys);
+
+    // a subset of the full read with the same values
+    for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+        QVERIFY2(full.contains(it.key()), qPrintable(it.key()));
+        QCOMPARE(it.value(), full.value(it.key()));
+    }
+}
+
+void tst_Qt5IniProjection::skippedSectionsAreNotChecked()
+{
+    const QByteArray data = projectionData + "[broken]\nnot a key\n";
+
+    bool ok;
+    QVERIFY(readFull(data, &ok).isEmpty());
+    QVERIFY(!ok);
+
+    QCOMPARE(readProjected(Qt5IniFormatReadSections, data, QStringList{ "net" }, &ok).size(), 3);
+    QVERIFY(ok);
+    QCOMPARE(readProjected(Qt5IniFormatReadKeyPrefixes, data, QStringList{ "net/" }, &ok).size(), 5);
+    QVERIFY(ok);
+
+    // a wanted section that is malformed still fails the read
+    readProjected(Qt5IniFormatReadSections, data, QStringList{ "broken" }, &ok);
+    QVERIFY(!ok);
+    readProjected(Qt5IniFormatReadKeyPrefixes, data, QStringList{ "b" }, &ok);
+    QVERIFY(!ok);
+}
+
+QTEST_APPLESS_MAIN(tst_Qt5IniProjection)
+
+#include "tst_qt5iniprojection.moc"
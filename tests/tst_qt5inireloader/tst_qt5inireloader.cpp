@@ -0,0 +1,187 @@
+#include "qt5inireloader.h"
+#include "qt5iniimpl.h"
+#include <QtTest>
+
+/*
+    Tests for Qt5IniIncrementalReloader: the exact change set of a reload,
+    how many sections it had to parse, and that its map always equals what
+    Qt5IniImpl::ReadData returns for the same bytes.
+*/
+
+static QSettings::SettingsMap readData(const QByteArray &data)
+{
+    QSettings::SettingsMap map;
+    if (!Qt5IniImpl::ReadData(data, map))
+        map.insert(QStringLiteral("read failed"), true);
+    return map;
+}
+
+class tst_Qt5IniReloader : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void reload_data();
+    void reload();
+    void sameBytesParseNothing();
+    void failedReloadKeepsState();
+};
+
+void tst_Qt5IniReloader::reload_data()
+{
+    QTest::addColumn<QByteArray>("before");
+    QTest::addColumn<QByteArray>("after");
+    QTest::addColumn<QStringList>("added");
+    QTest::addColumn<QStringList>("removed");
+    QTest::addColumn<QStringList>("changed");
+    QTest::addColumn<int>("parsedSections");
+
+    const QStringList none;
+    const QByteArray base = "top=0\n[a]\nx=1\ny=2\n[a/b]\nz=3\n[c]\nw=4\n";
+
+    QTest::newRow("unchanged") << base << base << none << none << none << 0;
+    QTest::newRow("section-added")
+        << base << base + "[d]\nv=5\nu=6\n"
+        << (QStringList() << "d/u" << "d/v") << none << none << 1;
+    QTest::newRow("section-removed")
+        << base << QByteArray("top=0\n[a]\nx=1\ny=2\n[a/b]\nz=3\n")
+        << none << (QStringList() << "c/w") << none << 0;
+    QTest::newRow("value-modified")
+        << base << QByteArray("top=0\n[a]\nx=10\ny=2\n[a/b]\nz=3\n[c]\nw=4\n")
+        << none << none << (QStringList() << "a/x") << 1;
+    QTest::newRow("keys-added-removed-modified")
+        << base << QByteArray("top=0\n[a]\nx=1\nn=7\n[a/b]\nz=3\n[c]\nw=40\n")
+        << (QStringList() << "a/n") << (QStringList() << "a/y") << (QStringList() << "c/w") << 2;
+    QTest::newRow("only-nested-section")
+        << base << QByteArray("top=0\n[a]\nx=1\ny=2\n[a/b]\nz=30\n[c]\nw=4\n")
+        << none << none << (QStringList() << "a/b/z") << 1;
+    QTest::newRow("comment-only")
+        << base << QByteArray("top=0\n[a]\n; note\nx=1\ny=2\n[a/b]\nz=3\n[c]\nw=4\n")
+        << none << none << none << 1;
+    QTest::newRow("general-modified")
+        << base << QByteArray("top=1\n[a]\nx=1\ny=2\n[a/b]\nz=3\n[c]\nw=4\n")
+        << none << none << (QStringList() << "top") << 1;
+    QTest::newRow("crlf-only")
+        << QByteArray("[a]\nx=1\n") << QByteArray("[a]\r\nx=1\r\n")
+        << none << none << none << 1;
+
+    // "a/b" can come from [General] and from [a]: the longer section name wins, as in ReadData
+    const QByteArray shadowed = "a/b=general\n[a]\nb=section\n";
+    QTest::newRow("shadowed-key-hidden-change")
+        << shadowed << QByteArray("a/b=other\n[a]\nb=section\n")
+        << none << none << none << 1;
+    QTest::newRow("shadowing-section-modified")
+        << shadowed << QByteArray("a/b=general\n[a]\nb=changed\n")
+        << none << none << (QStringList() << "a/b") << 1;
+    QTest::newRow("shadowing-section-removed")
+        << shadowed << QByteArray("a/b=general\n")
+        << none << none << (QStringList() << "a/b") << 0;
+    QTest::newRow("shadowing-section-added")
+        << QByteArray("a/b=general\n") << shadowed
+        << none << none << (QStringList() << "a/b") << 1;
+    QTest::newRow("both-removed")
+        << shadowed << QByteArray("[c]\nw=4\n")
+        << (QStringList() << "c/w") << (QStringList() << "a/b") << none << 2;
+
+    // "a/b/c" from [a] and from [a/b]: [a/b] wins
+    const QByteArray nested = "[a]\nb/c=outer\n[a/b]\nc=inner\n";
+    QTest::newRow("nested-shadowed-change")
+        << nested << QByteArray("[a]\nb/c=other\n[a/b]\nc=inner\n")
+        << none << none << none << 1;
+    QTest::newRow("nested-inner-removed")
+        << nested << QByteArray("[a]\nb/c=outer\n")
+        << none << none << (QStringList() << "a/b/c") << 0;
+
+    // [General] is always there, empty when the file starts with a section
+    QTest::newRow("general-emptied")
+        << QByteArray("top=0\n[a]\nx=1\n") << QByteArray("[a]\nx=1\n")
+        << none << (QStringList() << "top") << none << 1;
+
+    // a repeated section is one section made of both parts
+    QTest::newRow("repeated-section")
+        << QByteArray("[a]\nx=1\n[b]\ny=2\n[a]\nx=3\n") << QByteArray("[a]\nx=1\n[b]\ny=2\n[a]\nx=4\n")
+        << none << none << (QStringList() << "a/x") << 1;
+}
+
+void tst_Qt5IniReloader::reload()
+{
+    QFETCH(QByteArray, before);
+    QFETCH(QByteArray, after);
+    QFETCH(QStringList, added);
+    QFETCH(QStringList, removed);
+    QFETCH(QStringList, changed);
+    QFETCH(int, parsedSections);
+
+    Qt5IniIncrementalReloader reloader;
+    Qt5IniChangeSet changes;
+    QVERIFY(reloader.reload(before, &changes));
+    QCOMPARE(reloader.settingsMap(), readData(before));
+    QCOMPARE(changes.added, readData(before).keys());
+    QVERIFY(changes.removed.isEmpty());
+    QVERIFY(changes.changed.isEmpty());
+
+    QVERIFY(reloader.reload(after, &changes));
+    QCOMPARE(reloader.settingsMap(), readData(after));
+    QCOMPARE(changes.added, added);
+    QCOMPARE(changes.removed, removed);
+    QCOMPARE(changes.changed, changed);
+    QCOMPARE(changes.isEmpty(), added.isEmpty() && removed.isEmpty() && changed.isEmpty());
+    QCOMPARE(reloader.lastParsedSectionCount(), parsedSections);
+}
+
+void tst_Qt5IniReloader::sameBytesParseNothing()
+{
+    QByteArray data;
+    for (int s = 0; s < 50; ++s) {
+        data += "[section" + QByteArray::number(s) + "]\n";
+        for (int k = 0; k < 20; ++k)
+            data += "key" + QByteArray::number(k) + "=value\n";
+    }
+
+    Qt5IniIncrementalReloader reloader;
+    QVERIFY(reloader.reload(data));
+    QCOMPARE(reloader.lastParsedSectionCount(), 50);
+
+    // a copy with the same bytes, not the same buffer
+    Qt5IniChangeSet changes;
+    QVERIFY(reloader.reload(QByteArray(data.constData(), data.size()), &changes));
+    QVERIFY(changes.isEmpty());
+    QCOMPARE(reloader.lastParsedSectionCount(), 0);
+
+    data.replace("[section17]\nkey3=value\n", "[section17]\nkey3=other\n");
+    QVERIFY(reloader.reload(data, &changes));
+    QCOMPARE(changes.changed, QStringList() << "section17/key3");
+    QCOMPARE(reloader.lastParsedSectionCount(), 1);
+    QCOMPARE(reloader.settingsMap(), readData(data));
+
+    reloader.clear();
+    QVERIFY(reloader.settingsMap().isEmpty());
+    QVERIFY(reloader.reload(data, &changes));
+    QCOMPARE(changes.added.size(), 50 * 20);
+    QCOMPARE(reloader.lastParsedSectionCount(), 50);
+}
+
+void tst_Qt5IniReloader::failedReloadKeepsState()
+{
+    const QByteArray good = "[a]\nx=1\n[b]\ny=2\n";
+
+    Qt5IniIncrementalReloader reloader;
+    QVERIFY(reloader.reload(good));
+
+    Qt5IniChangeSet changes;
+    QVERIFY(!reloader.reload(QByteArray("[a]\nx=2\n[b]\nbad line\n"), &changes));
+    QVERIFY(changes.isEmpty());
+    QCOMPARE(reloader.settingsMap(), readData(good));
+
+    QVERIFY(!reloader.reload(QByteArray("[a\nx=2\n"), &changes));
+    QCOMPARE(reloader.settingsMap(), readData(good));
+
+    // the state after a failure still diffs against the last good reload
+    QVERIFY(reloader.reload(QByteArray("[a]\nx=2\n[b]\ny=2\n"), &changes));
+    QCOMPARE(changes.changed, QStringList() << "a/x");
+    QCOMPARE(reloader.lastParsedSectionCount(), 1);
+}
+
+QTEST_APPLESS_MAIN(tst_Qt5IniReloader)
+
+#include "tst_qt5inireloader.moc"
@@ -0,0 +1,298 @@
+#include "qt5inischema.h"
+#include "qt5iniimpl.h"
+#include <QRect>
+#include <QtTest>
+#include <limits>
+
+/*
+    Tests for the compile-time schemas: the perfect hash, the typed value
+    decoders, and Qt5IniSchema::read() against Qt5IniImpl::ReadData.
+*/
+
+struct Config
+{
+    int port = 8080;
+    uint workers = 4;
+    QString host = QStringLiteral("localhost");
+    bool verbose = false;
+    qint64 big = 0;
+    quint64 ubig = 0;
+    double ratio = 1.5;
+    QStringList tags;
+    QByteArray blob;
+    QRect rect;
+};
+
+static constexpr auto configSchema = qt5IniSchema<Config>(
+    qt5IniField("server/port", &Config::port),
+    qt5IniField("server/workers", &Config::workers),
+    qt5IniField("server/host", &Config::host),
+    qt5IniField("log/verbose", &Config::verbose),
+    qt5IniField("data/big", &Config::big),
+    qt5IniField("data/ubig", &Config::ubig),
+    qt5IniField("data/ratio", &Config::ratio),
+    qt5IniField("data/tags", &Config::tags),
+    qt5IniField("data/blob", &Config::blob),
+    qt5IniField("data/rect", &Config::rect));
+static_assert(configSchema.isValid(), "duplicate key in configSchema");
+
+static const char *const schemaKeys[] = {
+    "server/port", "server/workers", "server/host", "log/verbose", "data/big",
+    "data/ubig", "data/ratio", "data/tags", "data/blob", "data/rect"
+};
+
+template <typename T>
+static bool decoded(const char *raw, T &value)
+{
+    return Qt5IniSchemaDetail::decodeValue(raw, int(qstrlen(raw)), value);
+}
+
+class tst_Qt5IniSchema : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void perfectHash();
+    void decodeIntegers();
+    void decodeDoubleAndBool();
+    void decodeStrings();
+    void decodeThroughVariant();
+    void read();
+    void malformedLeavesOutputUntouched();
+};
+
+void tst_Qt5IniSchema::perfectHash()
+{
+    static constexpr Qt5IniSchemaDetail::PerfectHash<12> hash(
+        "a", "b", "c", "ab", "ba", "server/port", "server/host", "server/hosts",
+        "x/y/z", "general", "General", "key with spaces");
+    static_assert(hash.isValid(), "the keys are distinct");
+
+    const char *const keys[] = {
+        "a", "b", "c", "ab", "ba", "server/port", "server/host", "server/hosts",
+        "x/y/z", "general", "General", "key with spaces"
+    };
+    for (int i = 0; i < 12; ++i)
+        QCOMPARE(hash.indexOf(keys[i], int(qstrlen(keys[i]))), i);
+
+    // prefixes, extensions and other keys of the same length are not found
+    QCOMPARE(hash.indexOf("server/hos", 10), -1);
+    QCOMPARE(hash.indexOf("server/hostss", 13), -1);
+    QCOMPARE(hash.indexOf("d", 1), -1);
+    QCOMPARE(hash.indexOf("", 0), -1);
+    QCOMPARE(hash.indexOf("ab", 1), 0);
+
+    static constexpr Qt5IniSchemaDetail::PerfectHash<3> duplicate("a", "b", "a");
+    static_assert(!duplicate.isValid(), "a duplicate key cannot be placed");
+
+    for (int i = 0; i < 10; ++i)
+        QCOMPARE(configSchema.indexOf(schemaKeys[i], int(qstrlen(schemaKeys[i]))), i);
+}
+
+void tst_Qt5IniSchema::decodeIntegers()
+{
+    int i = 7;
+    QVERIFY(decoded("42", i));
+    QCOMPARE(i, 42);
+    QVERIFY(decoded(" -17\t", i));
+    QCOMPARE(i, -17);
+    QVERIFY(decoded("+3", i));
+    QCOMPARE(i, 3);
+    QVERIFY(decoded("\"12\"", i));
+    QCOMPARE(i, 12);
+    QVERIFY(decoded("\\x31\\x32", i));
+    QCOMPARE(i, 12);
+    QVERIFY(decoded("-2147483648", i));
+    QCOMPARE(i, int(-2147483647 - 1));
+
+    // failures leave the value alone
+    i = 5;
+    QVERIFY(!decoded("2147483648", i));
+    QVERIFY(!decoded("1.5", i));
+    QVERIFY(!decoded("", i));
+    QVERIFY(!decoded("12abc", i));
+    QCOMPARE(i, 5);
+
+    uint u = 0;
+    QVERIFY(decoded("4294967295", u));
+    QCOMPARE(u, 4294967295u);
+    QVERIFY(!decoded("4294967296", u));
+    QVERIFY(!decoded("-1", u));
+    QCOMPARE(u, 4294967295u);
+
+    qint64 l = 0;
+    QVERIFY(decoded("-9223372036854775808", l));
+    QCOMPARE(l, std::numeric_limits<qint64>::min());
+    QVERIFY(!decoded("9223372036854775808", l));
+    QCOMPARE(l, std::numeric_limits<qint64>::min());
+
+    quint64 ul = 0;
+    QVERIFY(decoded("18446744073709551615", ul));
+    QCOMPARE(ul, std::numeric_limits<quint64>::max());
+    QVERIFY(!decoded("18446744073709551616", ul));
+    QVERIFY(decoded("+5", ul));
+    QCOMPARE(ul, quint64(5));
+}
+
+void tst_Qt5IniSchema::decodeDoubleAndBool()
+{
+    double d = 0;
+    QVERIFY(decoded("2.5", d));
+    QCOMPARE(d, 2.5);
+    QVERIFY(decoded("1e3", d));
+    QCOMPARE(d, 1000.0);
+    QVERIFY(decoded("\"3.25\"", d));
+    QCOMPARE(d, 3.25);
+    QVERIFY(!decoded("abc", d));
+    QCOMPARE(d, 3.25);
+
+    // the QString to bool rule of QVariant: only "", "0" and "false" are false
+    bool b = false;
+    QVERIFY(decoded("true", b));
+    QCOMPARE(b, true);
+    QVERIFY(decoded("0", b));
+    QCOMPARE(b, false);
+    QVERIFY(decoded("yes", b));
+    QCOMPARE(b, true);
+    QVERIFY(decoded("FALSE", b));
+    QCOMPARE(b, false);
+    QVERIFY(decoded("1", b));
+    QCOMPARE(b, true);
+    QVERIFY(decoded("", b));
+    QCOMPARE(b, false);
+    QVERIFY(decoded("\"true\"", b));
+    QCOMPARE(b, true);
+    QVERIFY(decoded("\"false\"", b));
+    QCOMPARE(b, false);
+}
+
+void tst_Qt5IniSchema::decodeStrings()
+{
+    QString s;
+    QVERIFY(decoded("plain text", s));
+    QCOMPARE(s, QStringLiteral("plain text"));
+    QVERIFY(decoded("  padded\t", s));
+    QCOMPARE(s, QStringLiteral("padded"));
+    QVERIFY(decoded("a\\tb", s));
+    QCOMPARE(s, QStringLiteral("a\tb"));
+    QVERIFY(decoded("\"x, y\"", s));
+    QCOMPARE(s, QStringLiteral("x, y"));
+    QVERIFY(decoded("@@at", s));
+    QCOMPARE(s, QStringLiteral("@at"));
+    QVERIFY(decoded("@ByteArray(xyz)", s));
+    QCOMPARE(s, QStringLiteral("xyz"));
+    QVERIFY(decoded("caf\xe9", s));
+    QCOMPARE(s, QString::fromLatin1("caf\xe9"));
+
+    QStringList l;
+    QVERIFY(decoded("a, b,c", l));
+    QCOMPARE(l, QStringList() << "a" << "b" << "c");
+    QVERIFY(decoded("single", l));
+    QCOMPARE(l, QStringList() << "single");
+    QVERIFY(decoded("\"a,b\", c", l));
+    QCOMPARE(l, QStringList() << "a,b" << "c");
+    QVERIFY(decoded("@@x, y", l));
+    QCOMPARE(l, QStringList() << "@x" << "y");
+
+    QByteArray a;
+    QVERIFY(decoded("abc", a));
+    QCOMPARE(a, QByteArray("abc"));
+    QVERIFY(decoded("@ByteArray(a\\0b)", a));
+    QCOMPARE(a, QByteArray("a\0b", 3));
+    QVERIFY(decoded("\xe9", a));
+    QCOMPARE(a, QByteArray("\xc3\xa9"));
+}
+
+void tst_Qt5IniSchema::decodeThroughVariant()
+{
+    QRect r(9, 9, 9, 9);
+    QVERIFY(decoded("@Rect(1 2 3 4)", r));
+    QCOMPARE(r, QRect(1, 2, 3, 4));
+    QVERIFY(!decoded("junk", r));
+    QCOMPARE(r, QRect(1, 2, 3, 4));
+}
+
+void tst_Qt5IniSchema::read()
+{
+    const QByteArray data =
+        "server/port=1\n"
+        "[server]\n"
+        "port=2\n"
+        "host=\"example.org\"\n"
+        "workers=99999999999\n"
+        "[log]\n"
+        "verbose=true\n"
+        "level=3\n"
+        "[data]\n"
+        "big=-9000000000\n"
+        "ubig=18000000000000000000\n"
+        "ratio=0.25\n"
+        "tags=a, \"b,c\", d\n"
+        "blob=@ByteArray(xyz)\n"
+        "rect=@Rect(1 2 3 4)\n"
+        "[%U263A]\n"
+        "k=1\n";
+
+    Config config;
+    QSettings::SettingsMap overflow;
+    overflow.insert(QStringLiteral("kept"), 1);
+    QVERIFY(configSchema.read(data, config, &overflow));
+
+    // [server] comes after [General], so its port wins as in ReadData
+    QCOMPARE(config.port, 2);
+    QCOMPARE(config.host, QStringLiteral("example.org"));
+    // out of range for uint: the default stays
+    QCOMPARE(config.workers, 4u);
+    QCOMPARE(config.verbose, true);
+    QCOMPARE(config.big, Q_INT64_C(-9000000000));
+    QCOMPARE(config.ubig, Q_UINT64_C(18000000000000000000));
+    QCOMPARE(config.ratio, 0.25);
+    QCOMPARE(config.tags, QStringList() << "a" << "b,c" << "d");
+    QCOMPARE(config.blob, QByteArray("xyz"));
+    QCOMPARE(config.rect, QRect(1, 2, 3, 4));
+
+    // every key the schema does not know, as ReadData decodes it, next to what was there
+    QSettings::SettingsMap expected;
+    QVERIFY(Qt5IniImpl::ReadData(data, expected));
+    for (const char *key : schemaKeys)
+        expected.remove(QLatin1String(key));
+    expected.insert(QStringLiteral("kept"), 1);
+    QCOMPARE(overflow, expected);
+    QVERIFY(overflow.contains(QString(QChar(0x263a)) + QStringLiteral("/k")));
+
+    // every schema value agrees with ReadData
+    QSettings::SettingsMap full;
+    QVERIFY(Qt5IniImpl::ReadData(data, full));
+    QCOMPARE(config.host, full.value(QStringLiteral("server/host")).toString());
+    QCOMPARE(config.tags, full.value(QStringLiteral("data/tags")).toStringList());
+    QCOMPARE(config.blob, full.value(QStringLiteral("data/blob")).toByteArray());
+    QCOMPARE(config.rect, full.value(QStringLiteral("data/rect")).toRect());
+}
+
+void tst_Qt5IniSchema::malformedLeavesOutputUntouched()
+{
+    Config config;
+    config.port = 1234;
+    QSettings::SettingsMap overflow;
+    overflow.insert(QStringLiteral("kept"), 1);
+
+    // the first keys decode fine before the bad line is reached
+    QVERIFY(!configSchema.read(QByteArray("[server]\nport=2\nhost=h\nunknown=3\nbad line\n"),
+                               config, &overflow));
+    QCOMPARE(config.port, 1234);
+    QCOMPARE(config.host, QStringLiteral("localhost"));
+    QCOMPARE(overflow.size(), 1);
+    QCOMPARE(overflow.value(QStringLiteral("kept")), QVariant(1));
+
+    QVERIFY(!configSchema.read(QByteArray("[server\nport=2\n"), config, &overflow));
+    QCOMPARE(config.port, 1234);
+    QCOMPARE(overflow.size(), 1);
+
+    // without an overflow map unknown keys are dropped
+    QVERIFY(configSchema.read(QByteArray("[server]\nport=2\nunknown=3\n"), config));
+    QCOMPARE(config.port, 2);
+}
+
+QTEST_APPLESS_MAIN(tst_Qt5IniSchema)
+
+#include "tst_qt5inischema.moc"
@@ -0,0 +1,211 @@
+#include "qt5inisharedcache.h"
+#include "qt5iniimpl.h"
+#include <QSharedMemory>
+#include <QTemporaryDir>
+#include <QtTest>
+
+/*
+    Tests for Qt5IniSharedCache. Several caches on the same file in one
+    process stand in for several processes: each has its own QSharedMemory
+    attachment. The tests are skipped where shared memory is unavailable.
+*/
+
+// the segment header in front of the blob: magic, version, state and blob size
+static const int SegmentHeaderSize = 4 * sizeof(quint32);
+
+static const QByteArray cacheData =
+    "top=1\n"
+    "[net]\n"
+    "host=example.org\n"
+    "proxy/port=8080\n"
+    "list=a, \"b,c\"\n"
+    "[%U263A]\n"
+    "k=\\x263a\n";
+
+class tst_Qt5IniSharedCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void publishAndAttach();
+    void mapOutlivesCache();
+    void changedFileGetsNewSegment();
+    void invalidate();
+    void staleSegmentIsRebuilt();
+    void badFiles();
+
+private:
+    bool writeFile(const QByteArray &data);
+    QSettings::SettingsMap expectedMap(const QByteArray &data);
+
+    QTemporaryDir dir;
+    QString fileName;
+};
+
+bool tst_Qt5IniSharedCache::writeFile(const QByteArray &data)
+{
+    QFile file(fileName);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(data) == data.size();
+}
+
+QSettings::SettingsMap tst_Qt5IniSharedCache::expectedMap(const QByteArray &data)
+{
+    QSettings::SettingsMap map;
+    Qt5IniImpl::ReadData(data, map);
+    return map;
+}
+
+void tst_Qt5IniSharedCache::init()
+{
+    QVERIFY(dir.isValid());
+    fileName = dir.filePath(QLatin1String(QTest::currentTestFunction()) + QLatin1String(".ini"));
+    QVERIFY(writeFile(cacheData));
+}
+
+void tst_Qt5IniSharedCache::publishAndAttach()
+{
+    Qt5IniSharedCache first(fileName);
+    QCOMPARE(first.source(), Qt5IniSharedCache::NotLoaded);
+    QVERIFY(first.load());
+    if (first.source() == Qt5IniSharedCache::ParsedLocally)
+        QSKIP("shared memory is not available");
+    QCOMPARE(first.source(), Qt5IniSharedCache::Published);
+    QCOMPARE(first.map().toSettingsMap(), expectedMap(cacheData));
+
+    Qt5IniSharedCache second(fileName);
+    QVERIFY(second.load());
+    QCOMPARE(second.source(), Qt5IniSharedCache::Attached);
+    QCOMPARE(second.cacheKey(), first.cacheKey());
+    QCOMPARE(second.cacheKey(), Qt5IniSharedCache::cacheKey(fileName, cacheData));
+    QCOMPARE(second.map().toSettingsMap(), expectedMap(cacheData));
+
+    second.release();
+    QCOMPARE(second.source(), Qt5IniSharedCache::NotLoaded);
+    QVERIFY(second.map().isEmpty());
+    QVERIFY(!first.map().isEmpty());
+}
+
+void tst_Qt5IniSharedCache::mapOutlivesCache()
+{
+    Qt5IniCompactMap published;
+    Qt5IniCompactMap attached;
+    {
+        Qt5IniSharedCache first(fileName);
+        QVERIFY(first.load());
+        if (first.source() == Qt5IniSharedCache::ParsedLocally)
+            QSKIP("shared memory is not available");
+        Qt5IniSharedCache second(fileName);
+        QVERIFY(second.load());
+        QCOMPARE(second.source(), Qt5IniSharedCache::Attached);
+
+        published = first.map();
+        attached = second.map();
+        second.release();
+        // the caches are destroyed here, the maps still hold the segment
+    }
+    QCOMPARE(published.toSettingsMap(), expectedMap(cacheData));
+    QCOMPARE(attached.toSettingsMap(), expectedMap(cacheData));
+
+    // blob() is a copy, it stays valid after the last map is gone
+    const QByteArray blob = attached.blob();
+    published = Qt5IniCompactMap();
+    attached = Qt5IniCompactMap();
+    bool ok;
+    QCOMPARE(Qt5IniCompactMap::fromBlob(blob, &ok).toSettingsMap(), expectedMap(cacheData));
+    QVERIFY(ok);
+
+    // with every attachment gone the segment is too, so the next load publishes again
+    Qt5IniSharedCache third(fileName);
+    QVERIFY(third.load());
+    QCOMPARE(third.source(), Qt5IniSharedCache::Published);
+}
+
+void tst_Qt5IniSharedCache::changedFileGetsNewSegment()
+{
+    Qt5IniSharedCache first(fileName);
+    QVERIFY(first.load());
+    if (first.source() == Qt5IniSharedCache::ParsedLocally)
+        QSKIP("shared memory is not available");
+
+    const QByteArray changed = cacheData + "[added]\nk=2\n";
+    QVERIFY(writeFile(changed));
+
+    Qt5IniSharedCache second(fileName);
+    QVERIFY(second.load());
+    QCOMPARE(second.source(), Qt5IniSharedCache::Published);
+    QVERIFY(second.cacheKey() != first.cacheKey());
+    QCOMPARE(second.map().toSettingsMap(), expectedMap(changed));
+    QCOMPARE(first.map().toSettingsMap(), expectedMap(cacheData));
+
+    QVERIFY(first.load());
+    QCOMPARE(first.source(), Qt5IniSharedCache::Attached);
+    QCOMPARE(first.cacheKey(), second.cacheKey());
+}
+
+void tst_Qt5IniSharedCache::invalidate()
+{
+    Qt5IniSharedCache first(fileName);
+    QVERIFY(first.load());
+    if (first.source() == Qt5IniSharedCache::ParsedLocally)
+        QSKIP("shared memory is not available");
+    Qt5IniSharedCache second(fileName);
+    QVERIFY(second.load());
+    QVERIFY(!first.isInvalidated());
+
+    second.invalidate();
+    QVERIFY(first.isInvalidated());
+    QVERIFY(second.isInvalidated());
+    // maps already handed out keep working
+    QCOMPARE(first.map().toSettingsMap(), expectedMap(cacheData));
+
+    Qt5IniSharedCache third(fileName);
+    QVERIFY(third.load());
+    QCOMPARE(third.source(), Qt5IniSharedCache::ParsedLocally);
+    QVERIFY(!third.isInvalidated());
+    QCOMPARE(third.map().toSettingsMap(), expectedMap(cacheData));
+}
+
+void tst_Qt5IniSharedCache::staleSegmentIsRebuilt()
+{
+    // what a publisher that died before finishing leaves behind: a zeroed segment in the building state
+    const QByteArray blob = Qt5IniCompactMap::fromData(cacheData).blob();
+    QSharedMemory crashed(Qt5IniSharedCache::cacheKey(fileName, cacheData));
+    if (!crashed.create(SegmentHeaderSize + blob.size()))
+        QSKIP("shared memory is not available");
+
+    QElapsedTimer timer;
+    timer.start();
+    Qt5IniSharedCache cache(fileName);
+    QVERIFY(cache.load());
+    QCOMPARE(cache.source(), Qt5IniSharedCache::Published);
+    QCOMPARE(cache.map().toSettingsMap(), expectedMap(cacheData));
+    // it waited for the publisher for a bounded time, not forever
+    QVERIFY(timer.elapsed() < 30000);
+
+    // the rebuilt segment is the same one, and others attach to it normally
+    Qt5IniSharedCache other(fileName);
+    QVERIFY(other.load());
+    QCOMPARE(other.source(), Qt5IniSharedCache::Attached);
+    QCOMPARE(other.map().toSettingsMap(), expectedMap(cacheData));
+}
+
+void tst_Qt5IniSharedCache::badFiles()
+{
+    Qt5IniSharedCache missing(dir.filePath(QStringLiteral("missing.ini")));
+    QVERIFY(!missing.load());
+    QCOMPARE(missing.source(), Qt5IniSharedCache::NotLoaded);
+    QVERIFY(missing.map().isEmpty());
+    QVERIFY(Qt5IniSharedCache::cacheKey(missing.fileName(), QByteArray()).isEmpty());
+
+    QVERIFY(writeFile("k=1\nnot a key\n"));
+    Qt5IniSharedCache malformed(fileName);
+    QVERIFY(!malformed.load());
+    QCOMPARE(malformed.source(), Qt5IniSharedCache::NotLoaded);
+    QVERIFY(malformed.map().isEmpty());
+    QVERIFY(!malformed.isInvalidated());
+}
+
+QTEST_APPLESS_MAIN(tst_Qt5IniSharedCache)
+
+#include "tst_qt5inisharedcache.moc"
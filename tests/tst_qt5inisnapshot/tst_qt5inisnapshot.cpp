@@ -0,0 +1,191 @@
+#include "qt5inisnapshot.h"
+#include "qt5iniimpl.h"
+#include <QAtomicInt>
+#include <QBuffer>
+#include <QThread>
+#include <QtTest>
+
+/*
+    Tests for Qt5IniSnapshotHolder: publishing and reloading, the
+    generation every published snapshot carries, and refresh() on cached
+    snapshots, also while other threads read.
+*/
+
+static QSettings::SettingsMap numbered(int n)
+{
+    QSettings::SettingsMap map;
+    map.insert(QStringLiteral("gen"), n);
+    map.insert(QStringLiteral("check"), 2 * n);
+    return map;
+}
+
+static bool reloadFrom(Qt5IniSnapshotHolder &holder, const QByteArray &data,
+                       Qt::CaseSensitivity cs = Qt::CaseSensitive)
+{
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    return holder.reload(buffer, cs);
+}
+
+// refreshes its cached snapshot until it sees the last generation, checking every one it gets
+class SnapshotReader : public QThread
+{
+public:
+    SnapshotReader(const Qt5IniSnapshotHolder &holder, int lastGeneration)
+        : holder(holder), lastGeneration(lastGeneration), refreshes(0), failures(0) {}
+
+    void run() override
+    {
+        Qt5IniSnapshot cached = holder.snapshot();
+        int seen = cached.generation();
+        while (seen < lastGeneration) {
+            if (!holder.refresh(cached))
+                continue;
+            ++refreshes;
+            const int gen = cached.generation();
+            // each snapshot is complete, stamped with its own generation, and never older
+            if (gen < seen || cached.value(QStringLiteral("gen")).toInt() != gen
+                || cached.value(QStringLiteral("check")).toInt() != 2 * gen) {
+                failures.ref();
+            }
+            seen = gen;
+        }
+    }
+
+    const Qt5IniSnapshotHolder &holder;
+    const int lastGeneration;
+    int refreshes;
+    QAtomicInt failures;
+};
+
+class tst_Qt5IniSnapshot : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void publish();
+    void generationStamping();
+    void reload();
+    void reloadFailureKeepsSnapshot();
+    void refresh();
+    void concurrentReaders();
+};
+
+void tst_Qt5IniSnapshot::publish()
+{
+    Qt5IniSnapshotHolder holder;
+    QCOMPARE(holder.generation(), 0);
+    QVERIFY(holder.snapshot().isEmpty());
+    QCOMPARE(holder.snapshot().generation(), 0);
+
+    holder.publish(Qt5IniSnapshot(numbered(1)));
+    const Qt5IniSnapshot first = holder.snapshot();
+    QCOMPARE(holder.generation(), 1);
+    QCOMPARE(first.toSettingsMap(), numbered(1));
+
+    // a reader keeps its snapshot while newer ones are published
+    holder.publish(Qt5IniSnapshot(numbered(2)));
+    QCOMPARE(first.toSettingsMap(), numbered(1));
+    QCOMPARE(first.generation(), 1);
+    QCOMPARE(holder.snapshot().toSettingsMap(), numbered(2));
+
+    Qt5IniSnapshotHolder seeded(Qt5IniSnapshot(numbered(7)));
+    QCOMPARE(seeded.generation(), 0);
+    QCOMPARE(seeded.snapshot().toSettingsMap(), numbered(7));
+}
+
+void tst_Qt5IniSnapshot::generationStamping()
+{
+    Qt5IniSnapshotHolder holder;
+    const Qt5IniSnapshot unpublished(numbered(1));
+
+    // the same snapshot published twice is stamped twice; the caller's copy is never changed
+    holder.publish(unpublished);
+    holder.publish(unpublished);
+    QCOMPARE(unpublished.generation(), 0);
+    QCOMPARE(holder.generation(), 2);
+    QCOMPARE(holder.snapshot().generation(), 2);
+    QCOMPARE(holder.snapshot().toSettingsMap(), unpublished.toSettingsMap());
+
+    // republishing a snapshot taken from another holder restamps it here
+    Qt5IniSnapshotHolder other;
+    other.publish(holder.snapshot());
+    QCOMPARE(other.snapshot().generation(), 1);
+    QCOMPARE(holder.snapshot().generation(), 2);
+}
+
+void tst_Qt5IniSnapshot::reload()
+{
+    const QByteArray data = "[Net]\nHost=example.org\nport=8080\n";
+    QSettings::SettingsMap expected;
+    QVERIFY(Qt5IniImpl::ReadData(data, expected));
+
+    Qt5IniSnapshotHolder holder;
+    QVERIFY(reloadFrom(holder, data));
+    QCOMPARE(holder.generation(), 1);
+    QCOMPARE(holder.snapshot().generation(), 1);
+    QCOMPARE(holder.snapshot().toSettingsMap(), expected);
+    QCOMPARE(holder.snapshot().caseSensitivity(), Qt::CaseSensitive);
+
+    QVERIFY(reloadFrom(holder, data, Qt::CaseInsensitive));
+    QCOMPARE(holder.generation(), 2);
+    const Qt5IniSnapshot folded = holder.snapshot();
+    QCOMPARE(folded.caseSensitivity(), Qt::CaseInsensitive);
+    QCOMPARE(folded.value(QStringLiteral("net/host")), QVariant(QStringLiteral("example.org")));
+    QCOMPARE(folded.value(QStringLiteral("NET/PORT")), QVariant(QStringLiteral("8080")));
+    QCOMPARE(folded.originalCaseMap(), expected);
+}
+
+void tst_Qt5IniSnapshot::reloadFailureKeepsSnapshot()
+{
+    Qt5IniSnapshotHolder holder;
+    QVERIFY(reloadFrom(holder, "k=1\n"));
+    const Qt5IniSnapshot before = holder.snapshot();
+
+    QVERIFY(!reloadFrom(holder, "k=2\nnot a key\n"));
+    QVERIFY(!reloadFrom(holder, "[open\nk=3\n"));
+    QCOMPARE(holder.generation(), 1);
+    QCOMPARE(holder.snapshot().generation(), 1);
+    QCOMPARE(holder.snapshot().toSettingsMap(), before.toSettingsMap());
+}
+
+void tst_Qt5IniSnapshot::refresh()
+{
+    Qt5IniSnapshotHolder holder;
+    Qt5IniSnapshot cached = holder.snapshot();
+    QVERIFY(!holder.refresh(cached));
+
+    holder.publish(Qt5IniSnapshot(numbered(1)));
+    holder.publish(Qt5IniSnapshot(numbered(2)));
+    // several publications in between are caught up in one step
+    QVERIFY(holder.refresh(cached));
+    QCOMPARE(cached.generation(), 2);
+    QCOMPARE(cached.toSettingsMap(), numbered(2));
+    QVERIFY(!holder.refresh(cached));
+}
+
+void tst_Qt5IniSnapshot::concurrentReaders()
+{
+    const int lastGeneration = 2000;
+    Qt5IniSnapshotHolder holder;
+
+    QVector<SnapshotReader *> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.append(new SnapshotReader(holder, lastGeneration));
+        readers.last()->start();
+    }
+    for (int gen = 1; gen <= lastGeneration; ++gen)
+        holder.publish(Qt5IniSnapshot(numbered(gen)));
+
+    for (SnapshotReader *reader : readers) {
+        QVERIFY(reader->wait(60000));
+        QCOMPARE(reader->failures.load(), 0);
+        QVERIFY(reader->refreshes >= 1);
+    }
+    qDeleteAll(readers);
+}
+
+QTEST_APPLESS_MAIN(tst_Qt5IniSnapshot)
+
+#include "tst_qt5inisnapshot.moc"
@@ -0,0 +1,5 @@
+include(../tests.pri)
+
+TARGET = tst_qt5inisnapshot
+
+SOURCES += tst_qt5inisnapshot.cpp
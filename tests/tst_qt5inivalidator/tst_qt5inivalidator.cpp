@@ -0,0 +1,147 @@
+#include "qt5inivalidator.h"
+#include "qt5iniimpl.h"
+#include <QTemporaryDir>
+#include <QtTest>
+
+/*
+    Tests for Qt5IniValidator and Qt5IniImpl::CheckSyntax: the exact line,
+    column and kind of every issue in known-bad inputs, and a result that
+    agrees with Qt5IniImpl::ReadData.
+*/
+
+static const char *const kindNames[] = {
+    "UnterminatedSectionHeader", "MissingEquals", "EmptyKey", "BadKeyEscape",
+    "BadValueEscape", "UnknownValueEscape", "UnterminatedQuote"
+};
+
+// "line:column:Kind" for each issue, so a mismatch prints readably
+static QStringList described(const QVector<Qt5IniIssue> &issues)
+{
+    QStringList result;
+    for (const Qt5IniIssue &issue : issues) {
+        result << QString::number(issue.line) + QLatin1Char(':') + QString::number(issue.column)
+                  + QLatin1Char(':') + QLatin1String(kindNames[issue.kind]);
+    }
+    return result;
+}
+
+class tst_Qt5IniValidator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void issues_data();
+    void issues();
+    void validateFiles();
+};
+
+void tst_Qt5IniValidator::issues_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<bool>("expectedOk");
+    QTest::addColumn<QStringList>("expectedIssues");
+
+    QTest::newRow("empty") << QByteArray() << true << QStringList();
+    QTest::newRow("clean") << QByteArray("[s]\r\nk=1\r\n; c\r\n[%General]\nl=\"a,b\"\n") << true
+                           << QStringList();
+
+    // errors: the lines that make ReadFunc fail
+    QTest::newRow("only-line") << QByteArray("junk") << false << QStringList{ "1:1:MissingEquals" };
+    QTest::newRow("after-lf") << QByteArray("k=1\nbad\n") << false
+                              << QStringList{ "2:1:MissingEquals" };
+    QTest::newRow("after-crlf") << QByteArray("k=1\r\nbad\r\n") << false
+                                << QStringList{ "2:1:MissingEquals" };
+    QTest::newRow("after-cr") << QByteArray("k=1\rbad\r") << false
+                              << QStringList{ "2:1:MissingEquals" };
+    QTest::newRow("last-line-indented") << QByteArray("k=1\r\nl=2\r\n  bad") << false
+                                        << QStringList{ "3:3:MissingEquals" };
+    QTest::newRow("open-section-last") << QByteArray("[a]\r\nk=1\r\n[open") << false
+                                       << QStringList{ "3:1:UnterminatedSectionHeader" };
+    QTest::newRow("two-errors") << QByteArray("\n\n[s\nk=1\nbad") << false
+                                << QStringList{ "3:1:UnterminatedSectionHeader", "5:1:MissingEquals" };
+
+    // warnings: ReadFunc accepts these
+    QTest::newRow("empty-key") << QByteArray("=v") << true << QStringList{ "1:1:EmptyKey" };
+    QTest::newRow("bad-key-escape") << QByteArray("a%zz=1") << true
+                                    << QStringList{ "1:2:BadKeyEscape" };
+    QTest::newRow("bad-section-escape") << QByteArray("k=1\r\n[a%1]\r\n") << true
+                                        << QStringList{ "2:3:BadKeyEscape" };
+    QTest::newRow("unknown-escape") << QByteArray("k=a\\qb") << true
+                                    << QStringList{ "1:4:UnknownValueEscape" };
+    QTest::newRow("empty-hex-escape") << QByteArray("k=\\x\r\n") << true
+                                      << QStringList{ "1:3:BadValueEscape" };
+    QTest::newRow("trailing-backslash-last") << QByteArray("k=abc\\") << true
+                                             << QStringList{ "1:6:BadValueEscape" };
+    QTest::newRow("open-quote-last") << QByteArray("x=1\r\nk=\"open") << true
+                                     << QStringList{ "2:3:UnterminatedQuote" };
+    QTest::newRow("one-line-in-offset-order") << QByteArray("%x=\\q\"") << true
+            << QStringList{ "1:1:BadKeyEscape", "1:4:UnknownValueEscape", "1:6:UnterminatedQuote" };
+
+    QTest::newRow("mixed") << QByteArray("a=1\r\n\r\n  =v\r\n[s]\r\nb%=\\x\r\nc") << false
+            << QStringList{ "3:3:EmptyKey", "5:2:BadKeyEscape", "5:4:BadValueEscape",
+                            "6:1:MissingEquals" };
+}
+
+void tst_Qt5IniValidator::issues()
+{
+    QFETCH(QByteArray, data);
+    QFETCH(bool, expectedOk);
+    QFETCH(QStringList, expectedIssues);
+
+    // the result agrees with the reader, with and without an issue list
+    QSettings::SettingsMap map;
+    QCOMPARE(Qt5IniImpl::ReadData(data, map), expectedOk);
+    QCOMPARE(Qt5IniImpl::CheckSyntax(data, nullptr), expectedOk);
+    QCOMPARE(Qt5IniValidator::validate(data), expectedOk);
+
+    QVector<Qt5IniIssue> issues;
+    QCOMPARE(Qt5IniValidator::validate(data, &issues), expectedOk);
+    QCOMPARE(described(issues), expectedIssues);
+
+    bool hasError = false;
+    for (const Qt5IniIssue &issue : issues) {
+        QVERIFY(!issue.message().isEmpty());
+        hasError |= issue.isError();
+    }
+    QCOMPARE(hasError, !expectedOk);
+
+    QVector<Qt5IniImpl::SyntaxIssue> syntaxIssues;
+    QCOMPARE(Qt5IniImpl::CheckSyntax(data, &syntaxIssues), expectedOk);
+    QCOMPARE(syntaxIssues.size(), expectedIssues.size());
+}
+
+void tst_Qt5IniValidator::validateFiles()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const QByteArray contents[] = { "k=1\r\n", "k=1\r\nbad\r\n", "[a]\n=v" };
+    QStringList fileNames;
+    for (int i = 0; i < 3; ++i) {
+        fileNames << dir.filePath(QStringLiteral("f%1.ini").arg(i));
+        QFile file(fileNames.last());
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(contents[i]);
+    }
+    fileNames << dir.filePath(QStringLiteral("missing.ini"));
+
+    for (int threads : { 1, 4 }) {
+        const QVector<Qt5IniValidationResult> results =
+                Qt5IniValidator::validateFiles(fileNames, true, threads);
+        QCOMPARE(results.size(), 4);
+        for (int i = 0; i < 4; ++i)
+            QCOMPARE(results.at(i).fileName, fileNames.at(i));
+
+        QVERIFY(results.at(0).readable && results.at(0).ok);
+        QVERIFY(results.at(0).issues.isEmpty());
+        QVERIFY(results.at(1).readable && !results.at(1).ok);
+        QCOMPARE(described(results.at(1).issues), QStringList{ "2:1:MissingEquals" });
+        QVERIFY(results.at(2).readable && results.at(2).ok);
+        QCOMPARE(described(results.at(2).issues), QStringList{ "2:1:EmptyKey" });
+        QVERIFY(!results.at(3).readable && !results.at(3).ok);
+    }
+}
+
+QTEST_APPLESS_MAIN(tst_Qt5IniValidator)
+
+#include "tst_qt5inivalidator.moc"
@@ -0,0 +1,238 @@
+#include "allocationhooks.h"
+#include "nulldevice.h"
+#include "qt5iniformat.h"
+#include "qt5iniimpl.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <cstdio>
+#include <cstring>
+
+/*
+    qini-alloc: heap allocations, allocated bytes, heap peak and resident
+    peak of Qt5IniFormatReadFunc and Qt5IniFormatWriteFunc and of each of
+    their internal stages, for every file given on the command line. With
+    budgets set, the exit code is 1 as soon as a top-level operation goes
+    over one of them.
+*/
+
+/*
+    Collects one record per stage in fixed arrays, so that recording
+    allocates nothing and does not disturb the numbers it records.
+*/
+class StageRecorder : public Qt5IniImpl::StageObserver
+{
+public:
+    enum { MaxRecords = 64, MaxDepth = 16 };
+
+    struct Record
+    {
+        const char *stage;
+        int depth;
+        quint64 allocations;
+        quint64 bytes;
+        qint64 peakHeap;      // highest live heap above the level at the start
+        qint64 retained;      // live heap at the end minus live heap at the start
+        qint64 peakResident;  // VmHWM during the stage, -1 if unavailable
+    };
+
+    StageRecorder() : recordCount(0), depth(0) {}
+
+    void reset() { recordCount = 0; depth = 0; }
+
+    int count() const { return recordCount; }
+    const Record &at(int i) const { return records[i]; }
+
+    void stageBegin(const char *stage) override
+    {
+        if (recordCount == MaxRecords || depth == MaxDepth)
+            return;
+
+        // the enclosing stages keep the resident peak reached so far
+        const qint64 residentPeak = AllocationHooks::peakResidentBytes();
+        for (int d = 0; d < depth; ++d)
+            open[d].residentPeak = qMax(open[d].residentPeak, residentPeak);
+        const bool residentReset = AllocationHooks::resetPeakResident();
+
+        Frame &frame = open[depth];
+        frame.record = recordCount;
+        frame.start = AllocationHooks::counters();
+        frame.peakToken = AllocationHooks::beginPeakWindow();
+        frame.residentPeak = residentReset ? AllocationHooks::peakResidentBytes() : -1;
+
+        Record &record = records[recordCount++];
+        record.stage = stage;
+        record.depth = depth++;
+    }
+
+    void stageEnd(const char *stage) override
+    {
+        if (depth == 0 || strcmp(records[open[depth - 1].record].stage, stage) != 0)
+            return;
+
+        const Frame &frame = open[--depth];
+        const AllocationCounters end = AllocationHooks::counters();
+        const qint64 peak = AllocationHooks::endPeakWindow(frame.peakToken);
+
+        Record &record = records[frame.record];
+        record.allocations = end.allocations - frame.start.allocations;
+        record.bytes = end.bytes - frame.start.bytes;
+        record.peakHeap = peak - frame.start.liveBytes;
+        record.retained = end.liveBytes - frame.start.liveBytes;
+        record.peakResident = frame.residentPeak < 0
+                ? -1 : qMax(frame.residentPeak, AllocationHooks::peakResidentBytes());
+    }
+
+private:
+    struct Frame
+    {
+        int record;
+        AllocationCounters start;
+        qint64 peakToken;
+        qint64 residentPeak;
+    };
+
+    Record records[MaxRecords];
+    Frame open[MaxDepth];
+    int recordCount;
+    int depth;
+};
+
+struct Budgets
+{
+    double allocationsPerKey;
+    double bytesPerInputByte;
+    qint64 peakHeap;
+    qint64 peakResident;
+};
+
+static void printRecords(const StageRecorder &recorder, int keyCount, qint64 inputBytes)
+{
+    std::printf("  %-28s %10s %12s %12s %12s %12s %9s %9s\n", "stage", "allocs", "bytes",
+                "peak heap", "retained", "peak rss", "allocs/k", "bytes/B");
+    for (int i = 0; i < recorder.count(); ++i) {
+        const StageRecorder::Record &r = recorder.at(i);
+        char name[64];
+        std::snprintf(name, sizeof(name), "%*s%s", 2 * r.depth, "", r.stage);
+        std::printf("  %-28s %10llu %12llu %12lld %12lld %12lld %9.2f %9.2f\n", name,
+                    static_cast<unsigned long long>(r.allocations),
+                    static_cast<unsigned long long>(r.bytes),
+                    static_cast<long long>(r.peakHeap), static_cast<long long>(r.retained),
+                    static_cast<long long>(r.peakResident),
+                    keyCount > 0 ? double(r.allocations) / keyCount : 0.0,
+                    inputBytes > 0 ? double(r.bytes) / inputBytes : 0.0);
+    }
+}
+
+static bool checkBudgets(const StageRecorder &recorder, const Budgets &budgets,
+                         int keyCount, qint64 inputBytes)
+{
+    bool withinBudget = true;
+    for (int i = 0; i < recorder.count(); ++i) {
+        const StageRecorder::Record &r = recorder.at(i);
+        if (r.depth != 0)
+            continue;
+
+        const double allocationsPerKey = keyCount > 0 ? double(r.allocations) / keyCount : 0.0;
+        const double bytesPerInputByte = inputBytes > 0 ? double(r.bytes) / inputBytes : 0.0;
+        if (budgets.allocationsPerKey > 0 && allocationsPerKey > budgets.allocationsPerKey) {
+            std::printf("  BUDGET %s: %.2f allocations per key > %.2f\n", r.stage,
+                        allocationsPerKey, budgets.allocationsPerKey);
+            withinBudget = false;
+        }
+        if (budgets.bytesPerInputByte > 0 && bytesPerInputByte > budgets.bytesPerInputByte) {
+            std::printf("  BUDGET %s: %.2f allocated bytes per input byte > %.2f\n", r.stage,
+                        bytesPerInputByte, budgets.bytesPerInputByte);
+            withinBudget = false;
+        }
+        if (budgets.peakHeap > 0 && r.peakHeap > budgets.peakHeap) {
+            std::printf("  BUDGET %s: peak heap %lld > %lld bytes\n", r.stage,
+                        static_cast<long long>(r.peakHeap), static_cast<long long>(budgets.peakHeap));
+            withinBudget = false;
+        }
+        if (budgets.peakResident > 0 && r.peakResident > budgets.peakResident) {
+            std::printf("  BUDGET %s: peak resident %lld > %lld bytes\n", r.stage,
+                        static_cast<long long>(r.peakResident),
+                        static_cast<long long>(budgets.peakResident));
+            withinBudget = false;
+        }
+    }
+    return withinBudget;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("qini-alloc"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+        "Counts heap allocations, allocated bytes and memory peaks of reading and writing INI files."));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("files"), QStringLiteral("INI files to measure."),
+                                 QStringLiteral("file..."));
+    const QCommandLineOption allocationsOption(QStringLiteral("max-allocs-per-key"),
+        QStringLiteral("Fail if a read or write allocates more than <n> times per key."),
+        QStringLiteral("n"));
+    const QCommandLineOption bytesOption(QStringLiteral("max-bytes-per-input-byte"),
+        QStringLiteral("Fail if a read or write allocates more than <n> bytes per input byte."),
+        QStringLiteral("n"));
+    const QCommandLineOption peakHeapOption(QStringLiteral("max-peak-heap"),
+        QStringLiteral("Fail if the heap grows by more than <bytes> during a read or write."),
+        QStringLiteral("bytes"));
+    const QCommandLineOption peakResidentOption(QStringLiteral("max-peak-rss"),
+        QStringLiteral("Fail if the resident set peaks above <bytes> during a read or write."),
+        QStringLiteral("bytes"));
+    parser.addOption(allocationsOption);
+    parser.addOption(bytesOption);
+    parser.addOption(peakHeapOption);
+    parser.addOption(peakResidentOption);
+    parser.process(app);
+
+    const QStringList files = parser.positionalArguments();
+    if (files.isEmpty())
+        parser.showHelp(2);
+
+    Budgets budgets;
+    budgets.allocationsPerKey = parser.value(allocationsOption).toDouble();
+    budgets.bytesPerInputByte = parser.value(bytesOption).toDouble();
+    budgets.peakHeap = parser.value(peakHeapOption).toLongLong();
+    budgets.peakResident = parser.value(peakResidentOption).toLongLong();
+
+    StageRecorder recorder;
+    bool withinBudget = true;
+    for (const QString &fileName : files) {
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly)) {
+            std::fprintf(stderr, "qini-alloc: cannot open %s: %s\n", qPrintable(fileName),
+                         qPrintable(file.errorString()));
+            return 2;
+        }
+        const qint64 inputBytes = file.size();
+        NullDevice output;
+        output.open(QIODevice::WriteOnly);
+
+        QSettings::SettingsMap map;
+        recorder.reset();
+        Qt5IniImpl::SetStageObserver(&recorder);
+
+        recorder.stageBegin("Qt5IniFormatReadFunc");
+        const bool readOk = Qt5IniFormatReadFunc(file, map);
+        recorder.stageEnd("Qt5IniFormatReadFunc");
+
+        recorder.stageBegin("Qt5IniFormatWriteFunc");
+        const bool writeOk = Qt5IniFormatWriteFunc(output, map);
+        recorder.stageEnd("Qt5IniFormatWriteFunc");
+
+        Qt5IniImpl::SetStageObserver(nullptr);
+
+        std::printf("%s: %lld bytes, %d keys%s%s\n", qPrintable(fileName),
+                    static_cast<long long>(inputBytes), map.size(),
+                    readOk ? "" : ", read failed", writeOk ? "" : ", write failed");
+        printRecords(recorder, map.size(), inputBytes);
+        if (!checkBudgets(recorder, budgets, map.size(), inputBytes))
+            withinBudget = false;
+    }
+
+    return withinBudget ? 0 : 1;
+}
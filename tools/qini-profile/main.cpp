@@ -0,0 +1,312 @@
+#include "allocationhooks.h"
+#include "nulldevice.h"
+#include "qt5iniformat.h"
+#include "qt5iniimpl.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMap>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+
+/*
+    qini-profile: where the time and the allocations of reading and writing
+    an INI file go. Every section is read and written on its own, every
+    value is decoded and encoded on its own, and the results are summed up
+    per section and per value type; the most expensive sections and values
+    are listed at the end.
+*/
+
+struct Cost
+{
+    Cost() : nsecs(0), allocations(0), allocatedBytes(0) {}
+
+    void add(const Cost &other)
+    {
+        nsecs += other.nsecs;
+        allocations += other.allocations;
+        allocatedBytes += other.allocatedBytes;
+    }
+
+    qint64 nsecs;             // fastest of the repeated runs
+    quint64 allocations;      // of the first run, later runs may hit caches
+    quint64 allocatedBytes;
+};
+
+/*
+    Runs operation repeat times. Whatever operation builds must be
+    destroyed before it returns, so that freeing it is timed as well.
+*/
+template <typename Operation>
+static Cost measure(int repeat, Operation operation)
+{
+    Cost cost;
+    cost.nsecs = std::numeric_limits<qint64>::max();
+    for (int run = 0; run < repeat; ++run) {
+        const AllocationCounters before = AllocationHooks::counters();
+        QElapsedTimer timer;
+        timer.start();
+        operation();
+        const qint64 elapsed = timer.nsecsElapsed();
+        const AllocationCounters after = AllocationHooks::counters();
+
+        cost.nsecs = qMin(cost.nsecs, elapsed);
+        if (run == 0) {
+            cost.allocations = after.allocations - before.allocations;
+            cost.allocatedBytes = after.bytes - before.bytes;
+        }
+    }
+    return cost;
+}
+
+struct Profile
+{
+    Profile() : count(0), bytes(0), escapes(0) {}
+
+    QString name;
+    QString type;    // value type, values only
+    int count;       // keys of a section, values of a type
+    qint64 bytes;
+    qint64 escapes;  // '\' and '%' bytes, each starts an escape sequence
+    Cost read;
+    Cost write;
+};
+
+enum SortOrder { SortByTime, SortByAllocations, SortByBytes };
+
+static quint64 sortValue(const Profile &p, SortOrder order)
+{
+    switch (order) {
+    case SortByAllocations:
+        return p.read.allocations + p.write.allocations;
+    case SortByBytes:
+        return quint64(p.bytes);
+    case SortByTime:
+        break;
+    }
+    return quint64(p.read.nsecs + p.write.nsecs);
+}
+
+static int countEscapes(const QByteArray &data, int from, int to)
+{
+    int escapes = 0;
+    for (int i = from; i < to; ++i) {
+        const char ch = data.at(i);
+        if (ch == '\\' || ch == '%')
+            ++escapes;
+    }
+    return escapes;
+}
+
+// the QVariant type, marked when it came out of an @Variant blob
+static QString valueType(const QByteArray &data, int from, int to, const QVariant &value)
+{
+    while (from < to && (data.at(from) == ' ' || data.at(from) == '\t'))
+        ++from;
+    QString type = QLatin1String(value.typeName() ? value.typeName() : "invalid");
+    if (to - from >= 9 && qstrncmp(data.constData() + from, "@Variant(", 9) == 0)
+        type += QLatin1String(" @Variant");
+    return type;
+}
+
+static QString sectionDisplayName(const QString &section)
+{
+    return section.isEmpty() ? QStringLiteral("[General]")
+                             : QLatin1Char('[') + section.left(section.size() - 1) + QLatin1Char(']');
+}
+
+static void printHeader(const char *title)
+{
+    std::printf("  %-40s %7s %10s %8s %10s %10s %10s %10s\n", title, "count", "bytes",
+                "esc/kB", "read us", "allocs", "write us", "allocs");
+}
+
+static void printProfile(const QString &name, const Profile &p)
+{
+    QByteArray label = name.toUtf8();
+    if (label.size() > 40)
+        label = label.left(37) + "...";
+    std::printf("  %-40s %7d %10lld %8.1f %10.1f %10llu %10.1f %10llu\n", label.constData(),
+                p.count, static_cast<long long>(p.bytes),
+                p.bytes > 0 ? 1024.0 * p.escapes / p.bytes : 0.0,
+                p.read.nsecs / 1000.0, static_cast<unsigned long long>(p.read.allocations),
+                p.write.nsecs / 1000.0, static_cast<unsigned long long>(p.write.allocations));
+}
+
+static void printTop(const char *title, QVector<Profile> profiles, SortOrder order, int top)
+{
+    std::stable_sort(profiles.begin(), profiles.end(), [order](const Profile &a, const Profile &b) {
+        return sortValue(a, order) > sortValue(b, order);
+    });
+    std::printf("\n");
+    printHeader(title);
+    for (int i = 0; i < profiles.size() && i < top; ++i) {
+        const Profile &p = profiles.at(i);
+        printProfile(p.type.isEmpty() ? p.name : p.name + QLatin1String(" (") + p.type + QLatin1Char(')'), p);
+    }
+}
+
+static bool profileFile(const QString &fileName, const QByteArray &data, int repeat, int top,
+                        SortOrder order)
+{
+    // the whole file through the public entry points
+    QSettings::SettingsMap fileMap;
+    bool readOk = false;
+    Profile total;
+    total.bytes = data.size();
+    total.escapes = countEscapes(data, 0, data.size());
+    total.read = measure(repeat, [&]() {
+        QSettings::SettingsMap map;
+        readOk = Qt5IniImpl::ReadData(data, map);
+        fileMap.swap(map);
+    });
+    total.count = fileMap.size();
+    total.write = measure(repeat, [&]() {
+        NullDevice output;
+        output.open(QIODevice::WriteOnly);
+        Qt5IniFormatWriteFunc(output, fileMap);
+    });
+
+    std::printf("%s\n", qPrintable(fileName));
+    printHeader("file");
+    printProfile(readOk ? QStringLiteral("total") : QStringLiteral("total (read failed)"), total);
+
+    Qt5IniImpl::SectionMap sections;
+    Qt5IniImpl::ReadSections(data, sections);
+
+    QVector<Profile> sectionProfiles;
+    QVector<Profile> valueProfiles;
+    QMap<QString, Profile> typeProfiles;
+
+    for (Qt5IniImpl::SectionMap::const_iterator it = sections.constBegin(); it != sections.constEnd(); ++it) {
+        const QString &section = it.key();
+        const QByteArray &sectionData = it.value();
+
+        Profile sectionProfile;
+        sectionProfile.name = sectionDisplayName(section);
+        sectionProfile.bytes = sectionData.size();
+        sectionProfile.escapes = countEscapes(sectionData, 0, sectionData.size());
+
+        QSettings::SettingsMap sectionMap;
+        sectionProfile.read = measure(repeat, [&]() {
+            QSettings::SettingsMap map;
+            Qt5IniImpl::ReadSection(section, sectionData, map);
+            sectionMap.swap(map);
+        });
+        sectionProfile.count = sectionMap.size();
+        sectionProfile.write = measure(repeat, [&]() {
+            NullDevice output;
+            output.open(QIODevice::WriteOnly);
+            Qt5IniImpl::WriteFunc(output, sectionMap);
+        });
+        sectionProfiles.append(sectionProfile);
+
+        QVector<Qt5IniImpl::RawEntry> entries;
+        Qt5IniImpl::ReadRawSection(section, sectionData, entries);
+        for (const Qt5IniImpl::RawEntry &entry : entries) {
+            Profile valueProfile;
+            valueProfile.name = entry.key;
+            valueProfile.count = 1;
+            valueProfile.bytes = entry.valueEnd - entry.valueStart;
+            valueProfile.escapes = countEscapes(sectionData, entry.valueStart, entry.valueEnd);
+
+            QVariant value;
+            valueProfile.read = measure(repeat, [&]() {
+                QVariant decoded = Qt5IniImpl::DecodeValue(sectionData, entry.valueStart, entry.valueEnd);
+                value.swap(decoded);
+            });
+            QSettings::SettingsMap single;
+            single.insert(entry.key, value);
+            valueProfile.write = measure(repeat, [&]() {
+                NullDevice output;
+                output.open(QIODevice::WriteOnly);
+                Qt5IniImpl::WriteFunc(output, single);
+            });
+            valueProfile.type = valueType(sectionData, entry.valueStart, entry.valueEnd, value);
+
+            Profile &typeProfile = typeProfiles[valueProfile.type];
+            typeProfile.name = valueProfile.type;
+            typeProfile.count += 1;
+            typeProfile.bytes += valueProfile.bytes;
+            typeProfile.escapes += valueProfile.escapes;
+            typeProfile.read.add(valueProfile.read);
+            typeProfile.write.add(valueProfile.write);
+
+            valueProfiles.append(valueProfile);
+        }
+    }
+
+    std::printf("\n");
+    printHeader("section");
+    for (const Profile &p : sectionProfiles)
+        printProfile(p.name, p);
+
+    std::printf("\n");
+    printHeader("value type");
+    for (QMap<QString, Profile>::const_iterator it = typeProfiles.constBegin(); it != typeProfiles.constEnd(); ++it)
+        printProfile(it.key(), it.value());
+
+    printTop("most expensive sections", sectionProfiles, order, top);
+    printTop("most expensive values", valueProfiles, order, top);
+    std::printf("\n");
+    return readOk;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("qini-profile"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+        "Breaks the cost of reading and writing INI files down by section and value type."));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("files"), QStringLiteral("INI files to profile."),
+                                 QStringLiteral("file..."));
+    const QCommandLineOption topOption(QStringLiteral("top"),
+        QStringLiteral("List the <n> most expensive sections and values (default 10)."),
+        QStringLiteral("n"), QStringLiteral("10"));
+    const QCommandLineOption repeatOption(QStringLiteral("repeat"),
+        QStringLiteral("Time every operation <n> times and keep the fastest run (default 1)."),
+        QStringLiteral("n"), QStringLiteral("1"));
+    const QCommandLineOption sortOption(QStringLiteral("sort"),
+        QStringLiteral("Rank by time, allocs or bytes (default time)."),
+        QStringLiteral("key"), QStringLiteral("time"));
+    parser.addOption(topOption);
+    parser.addOption(repeatOption);
+    parser.addOption(sortOption);
+    parser.process(app);
+
+    const QStringList files = parser.positionalArguments();
+    if (files.isEmpty())
+        parser.showHelp(2);
+
+    const int top = qMax(0, parser.value(topOption).toInt());
+    const int repeat = qMax(1, parser.value(repeatOption).toInt());
+    SortOrder order = SortByTime;
+    if (parser.value(sortOption) == QLatin1String("allocs")) {
+        order = SortByAllocations;
+    } else if (parser.value(sortOption) == QLatin1String("bytes")) {
+        order = SortByBytes;
+    } else if (parser.value(sortOption) != QLatin1String("time")) {
+        std::fprintf(stderr, "qini-profile: unknown sort key %s\n", qPrintable(parser.value(sortOption)));
+        return 2;
+    }
+
+    bool allOk = true;
+    for (const QString &fileName : files) {
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly)) {
+            std::fprintf(stderr, "qini-profile: cannot open %s: %s\n", qPrintable(fileName),
+                         qPrintable(file.errorString()));
+            return 2;
+        }
+        if (!profileFile(fileName, file.readAll(), repeat, top, order))
+            allOk = false;
+    }
+
+    return allOk ? 0 : 1;
+}
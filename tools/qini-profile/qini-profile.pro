@@ -0,0 +1,25 @@
+QT -= gui
+
+TEMPLATE = app
+TARGET = qini-profile
+CONFIG += c++14 console
+CONFIG -= app_bundle
+
+!linux: error("qini-profile interposes the glibc allocator (tools/shared/allocationhooks.cpp) and only builds on Linux")
+
+# the library sources are compiled in so the tool can profile single sections and values
+DEFINES += QT5INIFORMAT_LIBRARY
+INCLUDEPATH += ../.. ../shared
+
+SOURCES += \
+    main.cpp \
+    ../shared/allocationhooks.cpp \
+    ../../qt5iniformat.cpp \
+    ../../qt5iniimpl.cpp
+
+HEADERS += \
+    ../shared/allocationhooks.h \
+    ../shared/nulldevice.h \
+    ../../Qt5IniFormat_global.h \
+    ../../qt5iniformat.h \
+    ../../qt5iniimpl.h
@@ -0,0 +1,179 @@
+#include "allocationhooks.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <malloc.h>
+#include <unistd.h>
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+}
+
+static std::atomic<quint64> allocationCount(0);
+static std::atomic<quint64> allocatedBytes(0);
+static std::atomic<qint64> liveBytes(0);
+static std::atomic<qint64> peakLiveBytes(0);
+
+static inline void raisePeak(qint64 live)
+{
+    qint64 peak = peakLiveBytes.load(std::memory_order_relaxed);
+    while (live > peak
+           && !peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+static inline void recordAllocation(void *ptr, size_t requested)
+{
+    if (!ptr)
+        return;
+    const qint64 usable = qint64(malloc_usable_size(ptr));
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(requested, std::memory_order_relaxed);
+    raisePeak(liveBytes.fetch_add(usable, std::memory_order_relaxed) + usable);
+}
+
+static inline void recordFree(void *ptr)
+{
+    if (ptr)
+        liveBytes.fetch_sub(qint64(malloc_usable_size(ptr)), std::memory_order_relaxed);
+}
+
+extern "C" {
+
+void *malloc(size_t size)
+{
+    void *ptr = __libc_malloc(size);
+    recordAllocation(ptr, size);
+    return ptr;
+}
+
+void *calloc(size_t count, size_t size)
+{
+    void *ptr = __libc_calloc(count, size);
+    recordAllocation(ptr, count * size);
+    return ptr;
+}
+
+void *realloc(void *old, size_t size)
+{
+    const qint64 oldUsable = old ? qint64(malloc_usable_size(old)) : 0;
+    void *ptr = __libc_realloc(old, size);
+    if (!ptr) {
+        // realloc(p, 0) frees p; any other failure leaves it alone
+        if (old && size == 0)
+            liveBytes.fetch_sub(oldUsable, std::memory_order_relaxed);
+        return ptr;
+    }
+    liveBytes.fetch_sub(oldUsable, std::memory_order_relaxed);
+    recordAllocation(ptr, size);
+    return ptr;
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+    void *ptr = __libc_memalign(alignment, size);
+    recordAllocation(ptr, size);
+    return ptr;
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void **result, size_t alignment, size_t size)
+{
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    void *ptr = memalign(alignment, size);
+    if (!ptr)
+        return ENOMEM;
+    *result = ptr;
+    return 0;
+}
+
+void free(void *ptr)
+{
+    recordFree(ptr);
+    __libc_free(ptr);
+}
+
+}
+
+AllocationCounters AllocationHooks::counters()
+{
+    AllocationCounters c;
+    c.allocations = allocationCount.load(std::memory_order_relaxed);
+    c.bytes = allocatedBytes.load(std::memory_order_relaxed);
+    c.liveBytes = liveBytes.load(std::memory_order_relaxed);
+    return c;
+}
+
+qint64 AllocationHooks::beginPeakWindow()
+{
+    return peakLiveBytes.exchange(liveBytes.load(std::memory_order_relaxed),
+                                  std::memory_order_relaxed);
+}
+
+qint64 AllocationHooks::endPeakWindow(qint64 token)
+{
+    const qint64 windowPeak = peakLiveBytes.load(std::memory_order_relaxed);
+    raisePeak(token);
+    return windowPeak;
+}
+
+// reads one "Name:   1234 kB" line of /proc/self/status without allocating
+static qint64 procStatusBytes(const char *name)
+{
+    const int fd = ::open("/proc/self/status", O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    char buffer[4096];
+    const ssize_t size = ::read(fd, buffer, sizeof(buffer) - 1);
+    ::close(fd);
+    if (size <= 0)
+        return -1;
+    buffer[size] = '\0';
+
+    const size_t nameLength = strlen(name);
+    for (const char *line = buffer; line && *line; ) {
+        if (strncmp(line, name, nameLength) == 0 && line[nameLength] == ':') {
+            qint64 kilobytes = 0;
+            for (const char *p = line + nameLength + 1; *p && *p != '\n'; ++p) {
+                if (*p >= '0' && *p <= '9')
+                    kilobytes = kilobytes * 10 + (*p - '0');
+            }
+            return kilobytes * 1024;
+        }
+        line = strchr(line, '\n');
+        if (line)
+            ++line;
+    }
+    return -1;
+}
+
+qint64 AllocationHooks::residentBytes()
+{
+    return procStatusBytes("VmRSS");
+}
+
+qint64 AllocationHooks::peakResidentBytes()
+{
+    return procStatusBytes("VmHWM");
+}
+
+bool AllocationHooks::resetPeakResident()
+{
+    const int fd = ::open("/proc/self/clear_refs", O_WRONLY);
+    if (fd < 0)
+        return false;
+    const bool ok = ::write(fd, "5", 1) == 1;
+    ::close(fd);
+    return ok;
+}
@@ -0,0 +1,41 @@
+#ifndef ALLOCATIONHOOKS_H
+#define ALLOCATIONHOOKS_H
+
+#include <QtGlobal>
+
+/*
+    Process wide heap accounting for the measuring tools. Linking
+    allocationhooks.cpp into an executable interposes glibc's malloc,
+    calloc, realloc, free and the aligned allocators; operator new and Qt's
+    containers go through them as well. None of the functions here allocate,
+    so they can be called in the middle of a measurement.
+*/
+struct AllocationCounters
+{
+    quint64 allocations;  // successful malloc/calloc/realloc/aligned calls
+    quint64 bytes;        // bytes requested by them
+    qint64 liveBytes;     // usable size of all blocks currently allocated
+};
+
+namespace AllocationHooks {
+
+AllocationCounters counters();
+
+/*
+    Heap peaks are tracked in nested windows: beginPeakWindow() starts
+    measuring from the current live size and returns a token, and
+    endPeakWindow() returns the highest live size since then and hands the
+    peak back to the enclosing window.
+*/
+qint64 beginPeakWindow();
+qint64 endPeakWindow(qint64 token);
+
+// VmRSS and VmHWM from /proc/self/status in bytes, or -1
+qint64 residentBytes();
+qint64 peakResidentBytes();
+// resets VmHWM to the current RSS through /proc/self/clear_refs
+bool resetPeakResident();
+
+}
+
+#endif // ALLOCATIONHOOKS_H
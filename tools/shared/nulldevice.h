@@ -0,0 +1,17 @@
+#ifndef NULLDEVICE_H
+#define NULLDEVICE_H
+
+#include <QIODevice>
+
+/*
+    A write-only device that swallows everything, so the measuring tools
+    can time and count the writer without also measuring an output buffer.
+*/
+class NullDevice : public QIODevice
+{
+protected:
+    qint64 readData(char *, qint64) override { return -1; }
+    qint64 writeData(const char *, qint64 len) override { return len; }
+};
+
+#endif // NULLDEVICE_H
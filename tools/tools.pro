@@ -0,0 +1,8 @@
+TEMPLATE = subdirs
+
+# both tools interpose the glibc allocator; elsewhere there is nothing to build
+linux {
+    SUBDIRS += \
+        qini-alloc \
+        qini-profile
+}